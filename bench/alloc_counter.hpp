@@ -0,0 +1,12 @@
+// Process-wide count of heap allocations, for the benchmarks.
+//
+// On glibc malloc, calloc, realloc and posix_memalign are interposed, which
+// also catches Armadillo's own buffers; elsewhere only operator new is
+// counted and alloc_counter_complete() returns false.
+#ifndef OPTIMLIGHT_BENCH_ALLOC_COUNTER_HPP
+#define OPTIMLIGHT_BENCH_ALLOC_COUNTER_HPP
+
+long alloc_count();
+bool alloc_counter_complete();
+
+#endif // OPTIMLIGHT_BENCH_ALLOC_COUNTER_HPP
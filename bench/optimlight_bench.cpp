@@ -0,0 +1,275 @@
+// Micro-benchmarks of the manifold kernels.
+//
+// Times metric, projection, retraction and vector_transport of Euclidean and
+// Stiefel for every metric, retraction and vector transport type, real and
+// complex, over a grid of (n, p) sizes. The operations are called through
+// the *_into variants with reused outputs, i.e. the steady state of a solver
+// iteration. Each row reports the time and the heap allocations per call,
+// and the linear algebra backend the library was built with.
+//
+//     optimlight_bench [--format csv|json] [--min-time seconds] [--sizes n1xp1,n2xp2,...]
+#include "alloc_counter.hpp"
+#include "manifolds/euclidean.hpp"
+#include "manifolds/stiefel.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace OptimLight;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Row {
+    std::string backend;
+    std::string manifold;
+    std::string field;
+    int n;
+    int p;
+    std::string op;
+    std::string variant;
+    long calls;
+    double ns_per_call;
+    double allocs_per_call;
+};
+
+struct Options {
+    std::string format = "csv";
+    double min_time = 0.05;
+    std::vector<std::pair<int, int>> sizes = {{10, 2}, {100, 5}, {1000, 10}, {5000, 20}};
+};
+
+const char* metric_name(MetricType t) {
+    switch (t) {
+        case EUCLIDEAN: return "EUCLIDEAN";
+        case CANONICAL: return "CANONICAL";
+        default: return "?";
+    }
+}
+
+const char* retraction_name(RetractionType t) {
+    switch (t) {
+        case RT_QF: return "RT_QF";
+        case RT_EXP: return "RT_EXP";
+        case RT_CAYLEY: return "RT_CAYLEY";
+        case RT_POLAR: return "RT_POLAR";
+        case RT_POLAR_NS: return "RT_POLAR_NS";
+        default: return "?";
+    }
+}
+
+const char* transport_name(VectorTransportType t) {
+    switch (t) {
+        case VT_PROJECTION: return "VT_PROJECTION";
+        case VT_PARALLELTRANSLATION: return "VT_PARALLELTRANSLATION";
+        case VT_DIFFERENTIATED: return "VT_DIFFERENTIATED";
+        case VT_CAYLEY: return "VT_CAYLEY";
+        case VT_RIGGING: return "VT_RIGGING";
+        case VT_PARALLELIZATION: return "VT_PARALLELIZATION";
+        default: return "?";
+    }
+}
+
+// Run f once to warm up (pool, output sizes), then repeatedly for at least
+// min_time seconds. Returns false if the operation is not supported.
+bool measure(const std::function<void()>& f, double min_time, Row& row) {
+    try {
+        f();
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    long calls = 0;
+    long batch = 1;
+    const long allocs_before = alloc_count();
+    const Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < min_time) {
+        for (long i = 0; i < batch; ++i) {
+            f();
+        }
+        calls += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    row.calls = calls;
+    row.ns_per_call = 1e9 * elapsed / calls;
+    row.allocs_per_call = static_cast<double>(alloc_count() - allocs_before) / calls;
+    return true;
+}
+
+// n x p matrix of standard normal entries over T
+template <typename T> la::Mat<T> random_mat(int n, int p);
+template <> la::mat random_mat<double>(int n, int p) { return la::randn(n, p); }
+template <> la::cx_mat random_mat<la::cx_double>(int n, int p) {
+    return la::complex(la::randn(n, p), la::randn(n, p));
+}
+
+// A point on St(n, p) and two tangent vectors there
+template <typename T>
+void random_point(int n, int p, ManifoldPoint& x, ManifoldVector& eta, ManifoldVector& xi) {
+    Stiefel<T> st(n, p);
+    la::Mat<T> Q(n, p), R(p, p);
+    la::qr_econ(Q, R, random_mat<T>(n, p));
+    x = ManifoldPoint(Q);
+    eta = st.projection(x, ManifoldVector(random_mat<T>(n, p)));
+    xi = st.projection(x, ManifoldVector(random_mat<T>(n, p)));
+    // Keep retraction steps short, as in a converging solver
+    eta *= 0.1;
+}
+
+void bench_manifold(const Manifold& M, const std::string& manifold, const std::string& variant,
+                    const std::string& op, const ManifoldPoint& x, const ManifoldVector& eta,
+                    const ManifoldVector& xi, const ManifoldPoint& y, const Options& options,
+                    Row base, std::vector<Row>& rows) {
+    ManifoldVector out;
+    volatile double sink = 0.0;
+    std::function<void()> f;
+    if (op == "metric") {
+        f = [&] { sink = M.metric(x, eta, xi); };
+    } else if (op == "projection") {
+        f = [&] { M.projection_into(x, xi, out); };
+    } else if (op == "retraction") {
+        f = [&] { M.retraction_into(x, eta, out); };
+    } else {
+        f = [&] { M.vector_transport_into(x, eta, y, xi, out); };
+    }
+    base.manifold = manifold;
+    base.op = op;
+    base.variant = variant;
+    if (measure(f, options.min_time, base)) {
+        rows.push_back(base);
+    } else {
+        std::fprintf(stderr, "skipped %s %s %s (unsupported)\n", manifold.c_str(),
+                     op.c_str(), variant.c_str());
+    }
+}
+
+template <typename T>
+void run_field(int n, int p, const Options& options, std::vector<Row>& rows) {
+    ManifoldPoint x, y;
+    ManifoldVector eta, xi;
+    random_point<T>(n, p, x, eta, xi);
+    Stiefel<T>(n, p).retraction_into(x, eta, y);
+
+    Row base;
+    base.backend = la::backend_name();
+    base.field = la::is_complex<T>::value ? "complex" : "real";
+    base.n = n;
+    base.p = p;
+
+    Euclidean<T> E(n, p);
+    for (const char* op : {"metric", "projection", "retraction", "vector_transport"}) {
+        bench_manifold(E, "Euclidean", "-", op, x, eta, xi, y, options, base, rows);
+    }
+
+    for (int t = 0; t < MetricTypeLength; ++t) {
+        Stiefel<T> S(n, p, static_cast<MetricType>(t));
+        bench_manifold(S, "Stiefel", metric_name(static_cast<MetricType>(t)), "metric",
+                       x, eta, xi, y, options, base, rows);
+    }
+    Stiefel<T> S(n, p);
+    bench_manifold(S, "Stiefel", "-", "projection", x, eta, xi, y, options, base, rows);
+    for (int t = 0; t < RetractionTypeLength; ++t) {
+        Stiefel<T> R(n, p, CANONICAL, static_cast<RetractionType>(t));
+        bench_manifold(R, "Stiefel", retraction_name(static_cast<RetractionType>(t)),
+                       "retraction", x, eta, xi, y, options, base, rows);
+    }
+    for (int t = 0; t < VectorTransportTypeLength; ++t) {
+        Stiefel<T> V(n, p, CANONICAL, RT_QF, static_cast<VectorTransportType>(t));
+        bench_manifold(V, "Stiefel", transport_name(static_cast<VectorTransportType>(t)),
+                       "vector_transport", x, eta, xi, y, options, base, rows);
+    }
+}
+
+void run(const Options& options, std::vector<Row>& rows) {
+    for (const auto& size : options.sizes) {
+        run_field<double>(size.first, size.second, options, rows);
+        run_field<la::cx_double>(size.first, size.second, options, rows);
+    }
+}
+
+void print_csv(const std::vector<Row>& rows) {
+    std::printf("backend,manifold,field,n,p,op,variant,calls,ns_per_call,allocs_per_call\n");
+    for (const Row& r : rows) {
+        std::printf("%s,%s,%s,%d,%d,%s,%s,%ld,%.1f,%.3f\n", r.backend.c_str(),
+                    r.manifold.c_str(), r.field.c_str(), r.n, r.p, r.op.c_str(),
+                    r.variant.c_str(), r.calls, r.ns_per_call, r.allocs_per_call);
+    }
+}
+
+void print_json(const std::vector<Row>& rows) {
+    std::printf("{\n  \"backend\": \"%s\",\n  \"allocation_counter\": \"%s\",\n"
+                "  \"results\": [\n",
+                la::backend_name(), alloc_counter_complete() ? "malloc" : "operator_new");
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Row& r = rows[i];
+        std::printf("    {\"manifold\": \"%s\", \"field\": \"%s\", \"n\": %d, \"p\": %d, "
+                    "\"op\": \"%s\", \"variant\": \"%s\", \"calls\": %ld, "
+                    "\"ns_per_call\": %.1f, \"allocs_per_call\": %.3f}%s\n",
+                    r.manifold.c_str(), r.field.c_str(), r.n, r.p, r.op.c_str(),
+                    r.variant.c_str(), r.calls, r.ns_per_call, r.allocs_per_call,
+                    i + 1 < rows.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+bool parse_sizes(const char* arg, std::vector<std::pair<int, int>>& sizes) {
+    sizes.clear();
+    std::string s(arg);
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t end = s.find(',', pos);
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+        int n = 0, p = 0;
+        if (std::sscanf(s.substr(pos, end - pos).c_str(), "%dx%d", &n, &p) != 2 ||
+            n <= 0 || p <= 0 || p > n) {
+            return false;
+        }
+        sizes.push_back(std::make_pair(n, p));
+        pos = end + 1;
+    }
+    return !sizes.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc &&
+                   parse_sizes(argv[i + 1], options.sizes)) {
+            ++i;
+        } else {
+            std::fprintf(stderr, "usage: %s [--format csv|json] [--min-time seconds] "
+                                 "[--sizes n1xp1,n2xp2,...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (options.format != "csv" && options.format != "json") {
+        std::fprintf(stderr, "unknown format %s\n", options.format.c_str());
+        return 1;
+    }
+
+    la::set_seed(42);
+    std::vector<Row> rows;
+    run(options, rows);
+    if (options.format == "json") {
+        print_json(rows);
+    } else {
+        print_csv(rows);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Times the canonical metric on Stiefel(n, p) against the reference formula
+// that forms the n x n products Z X^H, for a fixed p and growing n.
+//
+//     stiefel_metric_bench [p] [repeats]
+#include "manifolds/stiefel.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace OptimLight;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// <Z1, (I - X X^H / 2) Z2> with the n x n projector formed explicitly,
+// which is what the kernel avoids
+double reference_metric(const la::mat& X, const la::mat& Z1, const la::mat& Z2) {
+    la::mat P = -0.5 * X * la::adjoint(X);
+    la::add_identity(P, 1.0);
+    la::mat PZ2 = P * Z2;
+    return la::inner(Z1, PZ2);
+}
+
+template <typename F>
+double seconds_per_call(F f, int repeats) {
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        f();
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int p = argc > 1 ? std::atoi(argv[1]) : 10;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 20;
+    // The reference forms two n x n matrices, so it is skipped beyond this
+    const int reference_limit = 5000;
+    const int sizes[] = {500, 1000, 2000, 5000, 20000};
+
+    la::set_seed(42);
+    std::printf("%8s %4s %14s %14s %8s\n", "n", "p", "kernel [s]", "reference [s]", "speedup");
+    for (int n : sizes) {
+        Stiefel<double> M(n, p, CANONICAL);
+        la::mat Q(n, p), R(p, p);
+        la::qr_econ(Q, R, la::randn(n, p));
+        ManifoldPoint x(Q);
+        ManifoldVector eta = M.projection(x, ManifoldVector(la::randn(n, p)));
+        ManifoldVector xi = M.projection(x, ManifoldVector(la::randn(n, p)));
+
+        volatile double sink = 0.0;
+        double t_kernel = seconds_per_call([&] { sink = M.metric(x, eta, xi); }, repeats);
+        if (n > reference_limit) {
+            std::printf("%8d %4d %14.3e %14s %8s\n", n, p, t_kernel, "-", "-");
+            continue;
+        }
+        const double diff = std::abs(M.metric(x, eta, xi) -
+                                     reference_metric(x.as_mat(), eta.as_mat(), xi.as_mat()));
+        if (diff > 1e-8 * std::abs(M.metric(x, eta, xi)) + 1e-12) {
+            std::fprintf(stderr, "n = %d: kernel and reference differ by %g\n", n, diff);
+            return 1;
+        }
+        double t_reference = seconds_per_call([&] {
+            sink = reference_metric(x.as_mat(), eta.as_mat(), xi.as_mat());
+        }, repeats);
+        std::printf("%8d %4d %14.3e %14.3e %8.1f\n", n, p, t_kernel, t_reference,
+                    t_reference / t_kernel);
+    }
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include "evaluation_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace OptimLight
+{
+
+namespace {
+
+// Exact match, so that nearby line-search trials never share an entry
+bool same_point(const ManifoldPoint& a, const ManifoldPoint& b)
+{
+    if (a.is_complex() != b.is_complex() || a.n_rows() != b.n_rows() ||
+        a.n_cols() != b.n_cols()) {
+        return false;
+    }
+    if (a.is_complex()) {
+        const la::cx_mat& A = a.as_cx_mat();
+        return std::equal(la::data(A), la::data(A) + la::n_elem(A), la::data(b.as_cx_mat()));
+    }
+    const la::mat& A = a.as_mat();
+    return std::equal(la::data(A), la::data(A) + la::n_elem(A), la::data(b.as_mat()));
+}
+
+// Context key of the Manifold::egrad_to_rgrad correction at the point
+// A std::string, so that looking it up does not build a temporary
+const std::string hessian_correction_key = "manifold.hessian_correction";
+
+} // namespace
+
+EvaluationCache::EvaluationCache(const Problem* problem, int capacity)
+    : problem_(problem), stats_(nullptr), entries_(capacity), clock_(0), hits_(0), evaluations_(0)
+{
+    if (!problem_) {
+        throw std::runtime_error("EvaluationCache needs a problem");
+    }
+    if (capacity < 1) {
+        throw std::runtime_error("EvaluationCache capacity must be positive");
+    }
+}
+
+EvaluationContext& EvaluationCache::context(const ManifoldPoint& x)
+{
+    Entry* victim = &entries_[0];
+    for (Entry& entry : entries_) {
+        if (entry.used && same_point(entry.point, x)) {
+            entry.stamp = ++clock_;
+            return entry.ctx;
+        }
+        if (!entry.used || (victim->used && entry.stamp < victim->stamp)) {
+            victim = &entry;
+        }
+    }
+    // The point's storage is reused when the shape matches
+    victim->point = x;
+    victim->used = true;
+    victim->stamp = ++clock_;
+    victim->ctx.invalidate();
+    return victim->ctx;
+}
+
+EvaluationContext* EvaluationCache::find(const ManifoldPoint& x)
+{
+    for (Entry& entry : entries_) {
+        if (entry.used && same_point(entry.point, x)) {
+            return &entry.ctx;
+        }
+    }
+    return nullptr;
+}
+
+void EvaluationCache::clear()
+{
+    for (Entry& entry : entries_) {
+        entry.used = false;
+        entry.ctx.invalidate();
+    }
+}
+
+double EvaluationCache::objective(const ManifoldPoint& x)
+{
+    EvaluationContext& ctx = context(x);
+    count(ctx.has_f);
+    if (!ctx.has_f) {
+        ScopedTimer timer(stats_, PHASE_OBJECTIVE);
+        ctx.f = problem_->evaluate_objective(x, ctx);
+        ctx.has_f = true;
+    }
+    return ctx.f;
+}
+
+void EvaluationCache::objective_batch(const std::vector<const ManifoldPoint*>& xs,
+                                      std::vector<double>& values)
+{
+    values.resize(xs.size());
+    batch_points_.clear();
+    batch_slots_.clear();
+    for (size_t i = 0; i < xs.size(); ++i) {
+        const EvaluationContext* ctx = find(*xs[i]);
+        count(ctx && ctx->has_f);
+        if (ctx && ctx->has_f) {
+            values[i] = ctx->f;
+        } else {
+            batch_points_.push_back(xs[i]);
+            batch_slots_.push_back(i);
+        }
+    }
+    if (batch_points_.empty()) {
+        return;
+    }
+    {
+        ScopedTimer timer(stats_, PHASE_OBJECTIVE);
+        problem_->objective_batch(batch_points_, batch_values_);
+    }
+    for (size_t j = 0; j < batch_slots_.size(); ++j) {
+        values[batch_slots_[j]] = batch_values_[j];
+    }
+}
+
+void EvaluationCache::store_objective(const ManifoldPoint& x, double f)
+{
+    EvaluationContext& ctx = context(x);
+    ctx.f = f;
+    ctx.has_f = true;
+}
+
+void EvaluationCache::ensure_gradient(const ManifoldPoint& x, EvaluationContext& ctx)
+{
+    if (!ctx.has_egrad) {
+        ScopedTimer timer(stats_, PHASE_GRADIENT);
+        problem_->evaluate_gradient(x, ctx, ctx.egrad);
+        ctx.has_egrad = true;
+    }
+}
+
+const ManifoldVector& EvaluationCache::gradient(const ManifoldPoint& x)
+{
+    EvaluationContext& ctx = context(x);
+    count(ctx.has_egrad);
+    ensure_gradient(x, ctx);
+    return ctx.egrad;
+}
+
+const ManifoldVector& EvaluationCache::riemannian_gradient(const ManifoldPoint& x)
+{
+    EvaluationContext& ctx = context(x);
+    count(ctx.has_rgrad);
+    if (ctx.has_rgrad) {
+        return ctx.rgrad;
+    }
+    if (problem_->has_riemannian_gradient()) {
+        ScopedTimer timer(stats_, PHASE_GRADIENT);
+        problem_->evaluate_riemannian_gradient(x, ctx, ctx.rgrad);
+    } else {
+        ensure_gradient(x, ctx);
+        ScopedTimer timer(stats_, PHASE_GRADIENT);
+        ctx.rgrad_norm = manifold()->egrad_to_rgrad(x, ctx.egrad, ctx.rgrad,
+                                                    &ctx.store(hessian_correction_key));
+        ctx.has_rgrad_norm = true;
+    }
+    ctx.has_rgrad = true;
+    return ctx.rgrad;
+}
+
+double EvaluationCache::riemannian_gradient_norm(const ManifoldPoint& x)
+{
+    const ManifoldVector& rgrad = riemannian_gradient(x);
+    EvaluationContext& ctx = context(x);
+    if (!ctx.has_rgrad_norm) {
+        ctx.rgrad_norm = std::sqrt(manifold()->metric(x, rgrad, rgrad));
+        ctx.has_rgrad_norm = true;
+    }
+    return ctx.rgrad_norm;
+}
+
+void EvaluationCache::hessian_vector(const ManifoldPoint& x, const ManifoldVector& eta,
+                                     ManifoldVector& out)
+{
+    if (problem_->has_hessian()) {
+        ScopedTimer timer(stats_, PHASE_HESSIAN);
+        out = problem_->hessian_vector(x, eta);
+        return;
+    }
+    if (problem_->has_euclidean_hessian()) {
+        EvaluationContext& ctx = context(x);
+        ensure_gradient(x, ctx);
+        Array* correction = ctx.find(hessian_correction_key);
+        if (!correction) {
+            // The Riemannian gradient came from the problem, so the
+            // correction has not been formed at this point yet
+            correction = &ctx.store(hessian_correction_key);
+            manifold()->egrad_to_rgrad(x, ctx.egrad, scratch_, correction);
+        }
+        // The product and its conversion stay in scratch until eta has been
+        // read, in case out aliases eta
+        ScopedTimer timer(stats_, PHASE_HESSIAN);
+        ehess_ = problem_->euclidean_hessian_vector(x, eta);
+        manifold()->ehess_to_rhess(x, ctx.egrad, ehess_, eta, ehess_, correction);
+        std::swap(out, ehess_);
+        return;
+    }
+
+    // The gradient at x is looked up (and timed) before the Hessian timer starts
+    const ManifoldVector& grad_x = riemannian_gradient(x);
+    ScopedTimer timer(stats_, PHASE_HESSIAN);
+    problem_->finite_difference_hessian(x, grad_x, eta, out, &fd_work_);
+}
+
+double EvaluationCache::objective_and_gradient(const ManifoldPoint& x)
+{
+    EvaluationContext& ctx = context(x);
+    const bool hit = ctx.has_f && ctx.has_egrad;
+    count(hit);
+    if (!hit) {
+        // Only the missing part is evaluated, see
+        // Problem::evaluate_obj_and_grad
+        const Phase phase = ctx.has_f ? PHASE_GRADIENT
+                          : ctx.has_egrad ? PHASE_OBJECTIVE
+                          : PHASE_OBJECTIVE_AND_GRADIENT;
+        ScopedTimer timer(stats_, phase);
+        problem_->evaluate_obj_and_grad(x, ctx);
+        ctx.has_f = true;
+        ctx.has_egrad = true;
+    }
+    return ctx.f;
+}
+
+} // namespace OptimLight
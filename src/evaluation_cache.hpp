@@ -0,0 +1,115 @@
+#ifndef EVALUATION_CACHE_HPP
+#define EVALUATION_CACHE_HPP
+
+#include "problem.hpp"
+#include "evaluation_context.hpp"
+#include "optimizers/solver_stats.hpp"
+#include <vector>
+
+namespace OptimLight
+{
+
+// Memoizes a Problem's evaluations by point. Each of the last `capacity`
+// distinct points looked up keeps an EvaluationContext, the least recently
+// used one being evicted, so while a point is cached its objective,
+// Euclidean gradient and Riemannian gradient are computed at most once,
+// and the Problem's evaluate_* hooks can share intermediates between them.
+// Points are matched by exact value, not by address.
+//
+// With the default two entries, the second trial of a line search evicts
+// the iterate; the solver keeps the iterate's f and gradient itself, and
+// the accepted trial is still cached when its gradient is asked for.
+//
+// References returned stay valid until `capacity` other points have been
+// looked up after them.
+class EvaluationCache
+{
+public:
+    explicit EvaluationCache(const Problem* problem, int capacity = 2);
+
+    double objective(const ManifoldPoint& x);
+    const ManifoldVector& gradient(const ManifoldPoint& x);
+    const ManifoldVector& riemannian_gradient(const ManifoldPoint& x);
+
+    // |grad f(x)| in the manifold metric. Free when the Riemannian gradient
+    // was converted from the Euclidean one, otherwise one metric call.
+    double riemannian_gradient_norm(const ManifoldPoint& x);
+
+    // out = Hess f(x)[eta]: Problem::hessian_vector if the problem has an
+    // analytic Hessian, its Euclidean Hessian converted with the cached
+    // Euclidean gradient and Hessian correction at x if it has that,
+    // otherwise a finite-difference approximation built on the cached
+    // gradient at x, so each product costs one gradient evaluation. out may
+    // alias eta.
+    void hessian_vector(const ManifoldPoint& x, const ManifoldVector& eta, ManifoldVector& out);
+
+    // values[i] = f(*xs[i]). Points already cached are answered from the
+    // cache, the others are evaluated together by one
+    // Problem::objective_batch call. The batch does not enter the cache, so
+    // it never evicts the iterate; store_objective records the value of a
+    // point that is going to be used.
+    void objective_batch(const std::vector<const ManifoldPoint*>& xs, std::vector<double>& values);
+    void store_objective(const ManifoldPoint& x, double f);
+
+    // f(x), computing the Euclidean gradient in the same call through
+    // Problem::evaluate_obj_and_grad. Timed under
+    // PHASE_OBJECTIVE_AND_GRADIENT when neither was cached.
+    double objective_and_gradient(const ManifoldPoint& x);
+
+    // The context of x, created (evicting the least recently used point) if
+    // x is not cached
+    EvaluationContext& context(const ManifoldPoint& x);
+
+    // Time the evaluations into stats (null: off)
+    void set_stats(SolverStats* stats) { stats_ = stats; }
+
+    // Drop every cached point, e.g. after the problem data changed
+    void clear();
+
+    const Problem* problem() const { return problem_; }
+    Manifold* manifold() const { return problem_->get_manifold(); }
+
+    // Lookups answered from the cache and evaluations performed
+    long hits() const { return hits_; }
+    long evaluations() const { return evaluations_; }
+
+private:
+    struct Entry {
+        Entry() : used(false), stamp(0) {}
+        ManifoldPoint point;
+        bool used;
+        unsigned long stamp;
+        EvaluationContext ctx;
+    };
+
+    // The cached context of x, or null; unlike context() it never evicts
+    EvaluationContext* find(const ManifoldPoint& x);
+
+    // Fill ctx.egrad if it is not there yet, without counting a lookup
+    void ensure_gradient(const ManifoldPoint& x, EvaluationContext& ctx);
+
+    const Problem* problem_;
+    SolverStats* stats_;
+    ManifoldVector scratch_;
+    ManifoldVector ehess_;  // Euclidean Hessian-vector product to convert
+    FiniteDifferenceWorkspace fd_work_;
+    std::vector<const ManifoldPoint*> batch_points_;
+    std::vector<size_t> batch_slots_;
+    std::vector<double> batch_values_;
+    std::vector<Entry> entries_;
+    unsigned long clock_;
+    long hits_;
+    long evaluations_;
+
+    void count(bool hit) {
+        if (hit) {
+            ++hits_;
+        } else {
+            ++evaluations_;
+        }
+    }
+};
+
+} // namespace OptimLight
+
+#endif // EVALUATION_CACHE_HPP
@@ -0,0 +1,69 @@
+#ifndef EVALUATION_CONTEXT_HPP
+#define EVALUATION_CONTEXT_HPP
+
+#include "manifolds/manifold.hpp"
+#include <map>
+#include <string>
+
+namespace OptimLight
+{
+
+// Everything computed so far at one point: the objective value, the
+// Euclidean and Riemannian gradients, and named intermediates a Problem
+// wants to share between them (for example X^T A, needed by both f and its
+// gradient). EvaluationCache keeps one context per cached point and passes
+// it to the Problem's evaluate_* hooks.
+class EvaluationContext
+{
+public:
+    EvaluationContext()
+        : has_f(false), f(0.0), has_egrad(false), has_rgrad(false),
+          has_rgrad_norm(false), rgrad_norm(0.0) {}
+
+    // Intermediate `key`, or null if it has not been computed at this point
+    Array* find(const std::string& key) {
+        auto it = intermediates_.find(key);
+        return it != intermediates_.end() && it->second.valid ? &it->second.value : nullptr;
+    }
+
+    // Storage for intermediate `key`, marked as computed. The Array is kept
+    // when the context moves to another point, so refilling it with the same
+    // shape does not allocate.
+    Array& store(const std::string& key) {
+        Intermediate& entry = intermediates_[key];
+        entry.valid = true;
+        return entry.value;
+    }
+
+    // Forget all values, keeping the storage
+    void invalidate() {
+        has_f = false;
+        has_egrad = false;
+        has_rgrad = false;
+        has_rgrad_norm = false;
+        for (auto& entry : intermediates_) {
+            entry.second.valid = false;
+        }
+    }
+
+    bool has_f;
+    double f;
+    bool has_egrad;
+    ManifoldVector egrad;  // Euclidean gradient
+    bool has_rgrad;
+    ManifoldVector rgrad;  // Riemannian gradient
+    bool has_rgrad_norm;
+    double rgrad_norm;     // Norm of rgrad in the manifold metric
+
+private:
+    struct Intermediate {
+        Intermediate() : valid(false) {}
+        Array value;
+        bool valid;
+    };
+    std::map<std::string, Intermediate> intermediates_;
+};
+
+} // namespace OptimLight
+
+#endif // EVALUATION_CONTEXT_HPP
@@ -2,9 +2,9 @@
 
 namespace OptimLight {
 
-void Array::check_dimensions(const Array& other, const std::string& op) const {
+void Array::check_dimensions(const Array& other, const char* op) const {
     if (n_rows() != other.n_rows() || n_cols() != other.n_cols()) {
-        throw std::runtime_error("Matrix dimension mismatch in operator " + op);
+        throw std::runtime_error(std::string("Matrix dimension mismatch in operator ") + op);
     }
 }
 
@@ -17,111 +17,209 @@ void Array::check_mult_dimensions(const Array& other) const {
 Array& Array::operator=(const Array& other) {
     if (this != &other) {
         real_ = other.real_;
-        imag_ = other.imag_;
-        const_cast<bool&>(is_complex_) = other.is_complex_;
+        cx_ = other.cx_;
+        is_complex_ = other.is_complex_;
     }
     return *this;
 }
 
-Array Array::operator+(const Array& other) const {
+Array& Array::operator=(Array&& other) noexcept {
+    if (this != &other) {
+        real_ = std::move(other.real_);
+        cx_ = std::move(other.cx_);
+        is_complex_ = other.is_complex_;
+    }
+    return *this;
+}
+
+// Mixed real/complex operands only promote the real side; two complex
+// operands work on the interleaved buffers directly.
+Array Array::operator+(const Array& other) const & {
     check_dimensions(other, "+");
-    if (is_complex_ || other.is_complex_) {
-        arma::cx_mat result = as_complex() + other.as_complex();
-        return Array(result);  // Use explicit complex constructor
+    if (is_complex_ && other.is_complex_) {
+        return Array(la::cx_mat(cx_ + other.cx_));
+    }
+    if (is_complex_) {
+        return Array(la::cx_mat(cx_ + la::to_complex(other.real_)));
+    }
+    if (other.is_complex_) {
+        return Array(la::cx_mat(la::to_complex(real_) + other.cx_));
     }
-    return Array(real_ + other.real_, false);
+    return Array(la::mat(real_ + other.real_));
+}
+
+Array Array::operator+(const Array& other) && {
+    *this += other;
+    return std::move(*this);
 }
 
-Array Array::operator-(const Array& other) const {
+Array Array::operator-(const Array& other) const & {
     check_dimensions(other, "-");
-    if (is_complex_ || other.is_complex_) {
-        arma::cx_mat result = as_complex() - other.as_complex();
-        return Array(result);  // Use explicit complex constructor
+    if (is_complex_ && other.is_complex_) {
+        return Array(la::cx_mat(cx_ - other.cx_));
+    }
+    if (is_complex_) {
+        return Array(la::cx_mat(cx_ - la::to_complex(other.real_)));
     }
-    return Array(real_ - other.real_, false);
+    if (other.is_complex_) {
+        return Array(la::cx_mat(la::to_complex(real_) - other.cx_));
+    }
+    return Array(la::mat(real_ - other.real_));
+}
+
+Array Array::operator-(const Array& other) && {
+    *this -= other;
+    return std::move(*this);
 }
 
 Array Array::operator*(const Array& other) const {
     check_mult_dimensions(other);
-    if (is_complex_ || other.is_complex_) {
-        arma::cx_mat result = as_complex() * other.as_complex();
-        return Array(result);  // Use explicit complex constructor
+    if (is_complex_ && other.is_complex_) {
+        return Array(la::cx_mat(cx_ * other.cx_));
+    }
+    if (is_complex_) {
+        return Array(la::cx_mat(cx_ * la::to_complex(other.real_)));
+    }
+    if (other.is_complex_) {
+        return Array(la::cx_mat(la::to_complex(real_) * other.cx_));
     }
-    return Array(real_ * other.real_, false);
+    return Array(la::mat(real_ * other.real_));
 }
 
-Array Array::operator/(const Array& other) const {
+Array Array::operator/(const Array& other) const & {
     check_dimensions(other, "/");
-    if (is_complex_ || other.is_complex_) {
-        arma::cx_mat result = as_complex() / other.as_complex();
-        return Array(result);  // Use explicit complex constructor
+    if (is_complex_ && other.is_complex_) {
+        return Array(la::cx_mat(la::elem_div(cx_, other.cx_)));
     }
-    return Array(real_ / other.real_, false);
+    if (is_complex_) {
+        return Array(la::cx_mat(la::elem_div(cx_, la::to_complex(other.real_))));
+    }
+    if (other.is_complex_) {
+        return Array(la::cx_mat(la::elem_div(la::to_complex(real_), other.cx_)));
+    }
+    return Array(la::mat(la::elem_div(real_, other.real_)));
+}
+
+Array Array::operator/(const Array& other) && {
+    *this /= other;
+    return std::move(*this);
 }
 
 Array& Array::operator+=(const Array& other) {
     check_dimensions(other, "+=");
-    if (is_complex_ || other.is_complex_) {
-        arma::cx_mat result = as_complex() + other.as_complex();
-        real_ = arma::real(result);
-        imag_ = arma::imag(result);
-        const_cast<bool&>(is_complex_) = true;
+    if (is_complex_ && other.is_complex_) {
+        cx_ += other.cx_;
+    } else if (is_complex_) {
+        cx_ += la::to_complex(other.real_);
+    } else if (other.is_complex_) {
+        cx_ = la::to_complex(real_) + other.cx_;
+        la::reset(real_);
+        is_complex_ = true;
     } else {
         real_ += other.real_;
     }
     return *this;
 }
 
+Array& Array::operator-=(const Array& other) {
+    check_dimensions(other, "-=");
+    if (is_complex_ && other.is_complex_) {
+        cx_ -= other.cx_;
+    } else if (is_complex_) {
+        cx_ -= la::to_complex(other.real_);
+    } else if (other.is_complex_) {
+        cx_ = la::to_complex(real_) - other.cx_;
+        la::reset(real_);
+        is_complex_ = true;
+    } else {
+        real_ -= other.real_;
+    }
+    return *this;
+}
+
+Array& Array::operator/=(const Array& other) {
+    check_dimensions(other, "/=");
+    if (is_complex_ && other.is_complex_) {
+        cx_ = la::elem_div(cx_, other.cx_);
+    } else if (is_complex_) {
+        cx_ = la::elem_div(cx_, la::to_complex(other.real_));
+    } else if (other.is_complex_) {
+        cx_ = la::elem_div(la::to_complex(real_), other.cx_);
+        la::reset(real_);
+        is_complex_ = true;
+    } else {
+        real_ = la::elem_div(real_, other.real_);
+    }
+    return *this;
+}
+
 bool Array::operator==(const Array& other) const {
     if (n_rows() != other.n_rows() || n_cols() != other.n_cols() || 
         is_complex_ != other.is_complex_) {
         return false;
     }
     if (is_complex_) {
-        return arma::approx_equal(as_complex(), other.as_complex(), "absdiff", 1e-8);
+        return la::approx_equal(cx_, other.cx_, 1e-8);
     }
-    return arma::approx_equal(real_, other.real_, "absdiff", 1e-8);
+    return la::approx_equal(real_, other.real_, 1e-8);
 }
 
 bool Array::operator!=(const Array& other) const {
     return !(*this == other);
 }
 
-Array Array::operator-() const {
+Array Array::operator-() const & {
     if (is_complex_) {
-        return Array(-real_, -imag_);
+        return Array(la::cx_mat(-cx_));
     }
-    return Array(-real_, false);
+    return Array(la::mat(-real_));
+}
+
+Array Array::operator-() && {
+    *this *= -1.0;
+    return std::move(*this);
 }
 
-Array Array::operator*(double scalar) const {
+Array Array::operator*(double scalar) const & {
     if (is_complex_) {
-        return Array(scalar * real_, scalar * imag_);
+        return Array(la::cx_mat(scalar * cx_));
     }
-    return Array(scalar * real_, false);
+    return Array(la::mat(scalar * real_));
 }
 
-Array Array::operator*(std::complex<double> scalar) const {
-    arma::cx_mat result = scalar * as_complex();
-    return Array(result);  // This constructor handles complex conversion
+Array Array::operator*(double scalar) && {
+    *this *= scalar;
+    return std::move(*this);
+}
+
+Array Array::operator*(std::complex<double> scalar) const & {
+    if (is_complex_) {
+        return Array(la::cx_mat(scalar * cx_));
+    }
+    return Array(la::cx_mat(scalar * la::to_complex(real_)));
+}
+
+Array Array::operator*(std::complex<double> scalar) && {
+    *this *= scalar;
+    return std::move(*this);
 }
 
 Array& Array::operator*=(double scalar) {
-    real_ *= scalar;
     if (is_complex_) {
-        imag_ *= scalar;
+        cx_ *= scalar;
+    } else {
+        real_ *= scalar;
     }
     return *this;
 }
 
 Array& Array::operator*=(std::complex<double> scalar) {
     if (!is_complex_) {
-        const_cast<bool&>(is_complex_) = true;
-        imag_ = arma::zeros(real_.n_rows, real_.n_cols);
+        cx_ = la::to_complex(real_);
+        la::reset(real_);
+        is_complex_ = true;
     }
-    arma::cx_mat result = scalar * as_complex();
-    real_ = arma::real(result);
-    imag_ = arma::imag(result);
+    cx_ *= scalar;
     return *this;
 }
 
@@ -129,8 +227,16 @@ Array operator*(double scalar, const Array& arr) {
     return arr * scalar;
 }
 
+Array operator*(double scalar, Array&& arr) {
+    return std::move(arr) * scalar;
+}
+
 Array operator*(std::complex<double> scalar, const Array& arr) {
     return arr * scalar;
 }
 
-} // namespace OptimLight
\ No newline at end of file
+Array operator*(std::complex<double> scalar, Array&& arr) {
+    return std::move(arr) * scalar;
+}
+
+} // namespace OptimLight
@@ -4,80 +4,138 @@
 #include <complex>
 #include <memory>
 #include <stdexcept>
-#include <armadillo>
+#include <utility>
+#include "linalg.hpp"
 
 namespace OptimLight {
 
 class Array {
 private:
-    arma::mat real_;          // Real part storage
-    arma::mat imag_;          // Imaginary part storage
-    const bool is_complex_;   // Flag for complex data
+    la::mat real_;            // Real storage, used when !is_complex_
+    la::cx_mat cx_;           // Interleaved complex storage, used when is_complex_
+    bool is_complex_;         // Flag for complex data
 
 public:
     // Constructors
-    Array() : real_(), imag_(), is_complex_(false) {}
+    Array() : real_(), cx_(), is_complex_(false) {}
     Array(size_t rows, size_t cols, bool complex = false) 
-        : real_(rows, cols), imag_(complex ? arma::mat(rows, cols) : arma::mat()), 
+        : real_(complex ? la::mat() : la::mat(rows, cols)), 
+          cx_(complex ? la::cx_mat(rows, cols) : la::cx_mat()), 
           is_complex_(complex) {}
     
-    // Copy constructors from armadillo types
-    explicit Array(const arma::mat& m, bool complex = false) 
-        : real_(m), imag_(complex ? arma::mat(m.n_rows, m.n_cols) : arma::mat()), 
+    // Copy constructors from backend matrices
+    explicit Array(const la::mat& m, bool complex = false) 
+        : real_(complex ? la::mat() : m), 
+          cx_(complex ? la::to_complex(m) : la::cx_mat()), 
           is_complex_(complex) {}
     
-    explicit Array(const arma::cx_mat& m) 
-        : real_(arma::real(m)), imag_(arma::imag(m)), is_complex_(true) {}
+    explicit Array(const la::cx_mat& m) 
+        : real_(), cx_(m), is_complex_(true) {}
+
+    // Move constructors from backend matrices, taking over the buffer
+    explicit Array(la::mat&& m) 
+        : real_(std::move(m)), cx_(), is_complex_(false) {}
+
+    explicit Array(la::cx_mat&& m) 
+        : real_(), cx_(std::move(m)), is_complex_(true) {}
     
     // Constructor for complex matrix from real and imaginary parts
-    Array(const arma::mat& real_part, const arma::mat& imag_part) 
-        : real_(real_part), imag_(imag_part), is_complex_(true) {
-        if (real_part.n_rows != imag_part.n_rows || 
-            real_part.n_cols != imag_part.n_cols) {
+    Array(const la::mat& real_part, const la::mat& imag_part) 
+        : real_(), cx_(), is_complex_(true) {
+        if (la::rows(real_part) != la::rows(imag_part) || 
+            la::cols(real_part) != la::cols(imag_part)) {
             throw std::runtime_error("Dimension mismatch between real and imaginary parts");
         }
+        cx_ = la::complex(real_part, imag_part);
     }
 
     // Copy constructor
     Array(const Array& other) 
-        : real_(other.real_), imag_(other.imag_), is_complex_(other.is_complex_) {}
+        : real_(other.real_), cx_(other.cx_), is_complex_(other.is_complex_) {}
+
+    // Move constructor, takes over the buffers and leaves `other` empty
+    Array(Array&& other) noexcept
+        : real_(std::move(other.real_)), cx_(std::move(other.cx_)),
+          is_complex_(other.is_complex_) {}
     
     // Dimension info
-    size_t n_rows() const { return real_.n_rows; }
-    size_t n_cols() const { return real_.n_cols; }
-    size_t n_elem() const { return real_.n_elem; }
+    size_t n_rows() const { return is_complex_ ? la::rows(cx_) : la::rows(real_); }
+    size_t n_cols() const { return is_complex_ ? la::cols(cx_) : la::cols(real_); }
+    size_t n_elem() const { return is_complex_ ? la::n_elem(cx_) : la::n_elem(real_); }
     
-    // Data access
-    const arma::mat& real() const { return real_; }
-    const arma::mat& imag() const { return imag_; }
+    // Data access (copies for complex data, prefer as_mat()/as_cx_mat())
+    la::mat real() const { return is_complex_ ? la::real(cx_) : real_; }
+    la::mat imag() const { 
+        return is_complex_ ? la::imag(cx_) : la::zeros(n_rows(), n_cols()); 
+    }
     bool is_complex() const { return is_complex_; }
     
-    // Complex conversions and access
-    arma::cx_mat as_complex() const {
+    // Complex conversion, promotes real data to a new complex matrix
+    la::cx_mat as_complex() const {
         if (is_complex_) {
-            return arma::cx_mat(real_, imag_);
+            return cx_;
         }
-        return arma::cx_mat(real_, arma::zeros(n_rows(), n_cols()));
+        return la::to_complex(real_);
     }
     
     // Matrix access
-    arma::mat& as_mat() { 
+    la::mat& as_mat() { 
         if (is_complex_) throw std::runtime_error("Cannot access complex matrix as real");
         return real_; 
     }
-    const arma::mat& as_mat() const { 
+    const la::mat& as_mat() const { 
         if (is_complex_) throw std::runtime_error("Cannot access complex matrix as real");
         return real_; 
     }
 
+    // Zero-copy complex matrix access
+    la::cx_mat& as_cx_mat() { 
+        if (!is_complex_) throw std::runtime_error("Cannot access real matrix as complex");
+        return cx_; 
+    }
+    const la::cx_mat& as_cx_mat() const { 
+        if (!is_complex_) throw std::runtime_error("Cannot access real matrix as complex");
+        return cx_; 
+    }
+
+    // Storage as la::Mat<T> for T = double or la::cx_double, for code that
+    // fixes the scalar type at compile time. Throws like as_mat() and
+    // as_cx_mat() if the Array holds the other type.
+    template <typename T> la::Mat<T>& as();
+    template <typename T> const la::Mat<T>& as() const;
+
+    // Reshape the storage in place. Memory is only reallocated when the
+    // element count or the real/complex type changes, so reused output
+    // buffers stay allocation-free.
+    void set_size(size_t rows, size_t cols, bool complex) {
+        if (complex != is_complex_) {
+            if (complex) {
+                la::reset(real_);
+            } else {
+                la::reset(cx_);
+            }
+            is_complex_ = complex;
+        }
+        if (complex) {
+            la::resize(cx_, rows, cols);
+        } else {
+            la::resize(real_, rows, cols);
+        }
+    }
+
+    template <typename T> void set_size(size_t rows, size_t cols) {
+        set_size(rows, cols, la::is_complex<T>::value);
+    }
+
     // Submatrix extraction
     Array submat(size_t first_row, size_t first_col, 
                 size_t last_row, size_t last_col) const {
+        const size_t rows = last_row - first_row + 1;
+        const size_t cols = last_col - first_col + 1;
         if (is_complex_) {
-            return Array(real_.submat(first_row, first_col, last_row, last_col),
-                        imag_.submat(first_row, first_col, last_row, last_col));
+            return Array(la::cx_mat(la::block(cx_, first_row, first_col, rows, cols)));
         }
-        return Array(real_.submat(first_row, first_col, last_row, last_col), false);
+        return Array(la::mat(la::block(real_, first_row, first_col, rows, cols)));
     }
 
     // Submatrix assignment
@@ -87,39 +145,57 @@ public:
         if (is_complex_ != X.is_complex_) {
             throw std::runtime_error("Complex type mismatch in submatrix assignment");
         }
-        real_.submat(first_row, first_col, last_row, last_col) = X.real_;
+        const size_t rows = last_row - first_row + 1;
+        const size_t cols = last_col - first_col + 1;
         if (is_complex_) {
-            imag_.submat(first_row, first_col, last_row, last_col) = X.imag_;
+            la::block(cx_, first_row, first_col, rows, cols) = X.cx_;
+        } else {
+            la::block(real_, first_row, first_col, rows, cols) = X.real_;
         }
     }
 
-    // Operators (declarations)
+    // Operators (declarations). The && overloads are picked when the left
+    // operand is a temporary, as in a + b + c, and write the result into its
+    // buffer instead of allocating a new one.
     Array& operator=(const Array& other);
-    Array operator+(const Array& other) const;
-    Array operator-(const Array& other) const;
+    Array& operator=(Array&& other) noexcept;
+    Array operator+(const Array& other) const &;
+    Array operator+(const Array& other) &&;
+    Array operator-(const Array& other) const &;
+    Array operator-(const Array& other) &&;
     Array operator*(const Array& other) const;
-    Array operator/(const Array& other) const;
+    Array operator/(const Array& other) const &;
+    Array operator/(const Array& other) &&;
     Array& operator+=(const Array& other);
     Array& operator-=(const Array& other);
-    Array& operator*=(const Array& other);
     Array& operator/=(const Array& other);
     bool operator==(const Array& other) const;
     bool operator!=(const Array& other) const;
 
-    Array operator-() const;  // Unary negation
-    Array operator*(double scalar) const;  // Scalar multiplication
-    Array operator*(std::complex<double> scalar) const;  // Complex scalar multiplication
+    Array operator-() const &;  // Unary negation
+    Array operator-() &&;
+    Array operator*(double scalar) const &;  // Scalar multiplication
+    Array operator*(double scalar) &&;
+    Array operator*(std::complex<double> scalar) const &;  // Complex scalar multiplication
+    Array operator*(std::complex<double> scalar) &&;
     friend Array operator*(double scalar, const Array& arr);  // Left scalar multiplication
+    friend Array operator*(double scalar, Array&& arr);
     friend Array operator*(std::complex<double> scalar, const Array& arr);  // Left complex scalar multiplication
+    friend Array operator*(std::complex<double> scalar, Array&& arr);
 
     // Add scalar compound assignments
     Array& operator*=(double scalar);
     Array& operator*=(std::complex<double> scalar);
 
 private:
-    void check_dimensions(const Array& other, const std::string& op) const;
+    void check_dimensions(const Array& other, const char* op) const;
     void check_mult_dimensions(const Array& other) const;
 };
 
+template <> inline la::mat& Array::as<double>() { return as_mat(); }
+template <> inline const la::mat& Array::as<double>() const { return as_mat(); }
+template <> inline la::cx_mat& Array::as<la::cx_double>() { return as_cx_mat(); }
+template <> inline const la::cx_mat& Array::as<la::cx_double>() const { return as_cx_mat(); }
+
 } // namespace OptimLight
 #endif // ARRAY_HPP
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef ARRAY_VIEW_HPP
+#define ARRAY_VIEW_HPP
+
+#include "array.hpp"
+
+namespace OptimLight {
+
+// Non-owning view of the block [first_row, first_row + n_rows) x
+// [first_col, first_col + n_cols) of an Array. Product-type manifolds hand
+// these to their components so each component reads its block of the
+// larger point in place. The parent must outlive the view.
+class ConstArrayView {
+public:
+    // Whole-array view
+    ConstArrayView(const Array& parent)
+        : parent_(&parent), first_row_(0), first_col_(0),
+          n_rows_(parent.n_rows()), n_cols_(parent.n_cols()) {}
+
+    ConstArrayView(const Array& parent, size_t first_row, size_t first_col,
+                   size_t n_rows, size_t n_cols)
+        : parent_(&parent), first_row_(first_row), first_col_(first_col),
+          n_rows_(n_rows), n_cols_(n_cols) {
+        if (first_row + n_rows > parent.n_rows() || first_col + n_cols > parent.n_cols()) {
+            throw std::out_of_range("ArrayView block exceeds parent dimensions");
+        }
+    }
+
+    size_t n_rows() const { return n_rows_; }
+    size_t n_cols() const { return n_cols_; }
+    size_t n_elem() const { return n_rows_ * n_cols_; }
+    bool is_complex() const { return parent_->is_complex(); }
+
+    // Backend views of the block, no data is copied
+    template <typename T> la::ConstBlock<T> as() const {
+        return la::block(parent_->as<T>(), first_row_, first_col_, n_rows_, n_cols_);
+    }
+    la::ConstBlock<double> as_mat() const { return as<double>(); }
+    la::ConstBlock<la::cx_double> as_cx_mat() const { return as<la::cx_double>(); }
+
+    // Copy the block into `out`, reusing its storage when the size matches
+    void copy_to(Array& out) const {
+        out.set_size(n_rows_, n_cols_, is_complex());
+        if (is_complex()) {
+            out.as_cx_mat() = as_cx_mat();
+        } else {
+            out.as_mat() = as_mat();
+        }
+    }
+
+private:
+    const Array* parent_;
+    size_t first_row_, first_col_;
+    size_t n_rows_, n_cols_;
+};
+
+// Writable counterpart of ConstArrayView. Like a reference, a const
+// ArrayView still writes through to its parent.
+class ArrayView {
+public:
+    ArrayView(Array& parent)
+        : parent_(&parent), first_row_(0), first_col_(0),
+          n_rows_(parent.n_rows()), n_cols_(parent.n_cols()) {}
+
+    ArrayView(Array& parent, size_t first_row, size_t first_col,
+              size_t n_rows, size_t n_cols)
+        : parent_(&parent), first_row_(first_row), first_col_(first_col),
+          n_rows_(n_rows), n_cols_(n_cols) {
+        if (first_row + n_rows > parent.n_rows() || first_col + n_cols > parent.n_cols()) {
+            throw std::out_of_range("ArrayView block exceeds parent dimensions");
+        }
+    }
+
+    operator ConstArrayView() const {
+        return ConstArrayView(*parent_, first_row_, first_col_, n_rows_, n_cols_);
+    }
+
+    size_t n_rows() const { return n_rows_; }
+    size_t n_cols() const { return n_cols_; }
+    size_t n_elem() const { return n_rows_ * n_cols_; }
+    bool is_complex() const { return parent_->is_complex(); }
+
+    template <typename T> la::Block<T> as() const {
+        return la::block(parent_->as<T>(), first_row_, first_col_, n_rows_, n_cols_);
+    }
+    la::Block<double> as_mat() const { return as<double>(); }
+    la::Block<la::cx_double> as_cx_mat() const { return as<la::cx_double>(); }
+
+    // Write X into the block
+    void assign(const Array& X) const {
+        if (X.n_rows() != n_rows_ || X.n_cols() != n_cols_) {
+            throw std::runtime_error("Dimension mismatch in ArrayView assignment");
+        }
+        if (is_complex() != X.is_complex()) {
+            throw std::runtime_error("Complex type mismatch in ArrayView assignment");
+        }
+        if (is_complex()) {
+            as_cx_mat() = X.as_cx_mat();
+        } else {
+            as_mat() = X.as_mat();
+        }
+    }
+
+private:
+    Array* parent_;
+    size_t first_row_, first_col_;
+    size_t n_rows_, n_cols_;
+};
+
+} // namespace OptimLight
+#endif // ARRAY_VIEW_HPP
@@ -1,59 +1,171 @@
 #include "euclidean.hpp"
+#include <cmath>
 #include <stdexcept>
 
 namespace OptimLight {
 
-void Euclidean::check_dimensions(const ManifoldPoint& x, const std::string& name) const {
+template <typename T>
+void Euclidean<T>::check_dimensions(const ConstArrayView& x, const char* name) const {
+    if (!validation::dimensions_enabled) return;
     if (x.n_rows() != n || x.n_cols() != p) {
-        throw std::runtime_error(name + " has wrong dimensions. Expected " + 
+        throw std::runtime_error(std::string(name) + " has wrong dimensions. Expected " + 
                                std::to_string(n) + "x" + std::to_string(p) + 
                                ", got " + std::to_string(x.n_rows()) + "x" + 
                                std::to_string(x.n_cols()));
     }
 }
 
-double Euclidean::metric(const ManifoldPoint& x,
-                        const ManifoldVector& etax,
-                        const ManifoldVector& xix) const {
+template <typename T>
+double Euclidean<T>::metric(const ManifoldPoint& x,
+                           const ManifoldVector& etax,
+                           const ManifoldVector& xix) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
     check_dimensions(xix, "xix");
 
-    if (is_complex_) {
-        arma::cx_mat etax_cx = etax.as_complex();
-        arma::cx_mat xix_cx = xix.as_complex();
-        return std::real(arma::accu(arma::conj(etax_cx) % xix_cx));
-    } else {
-        return arma::accu(etax.real() % xix.real());
-    }
+    return la::inner(etax.as<T>(), xix.as<T>());
+}
+
+template <typename T>
+ManifoldVector Euclidean<T>::projection(const ManifoldPoint& x,
+                                      const ManifoldVector& etax) const {
+    ManifoldVector result;
+    projection_into(x, etax, result);
+    return result;
+}
+
+template <typename T>
+ManifoldPoint Euclidean<T>::retraction(const ManifoldPoint& x,
+                                      const ManifoldVector& etax) const {
+    ManifoldPoint result;
+    retraction_into(x, etax, result);
+    return result;
+}
+
+template <typename T>
+ManifoldVector Euclidean<T>::vector_transport(const ManifoldPoint& x,
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y,
+                                            const ManifoldVector& xix) const {
+    ManifoldVector result;
+    vector_transport_into(x, etax, y, xix, result);
+    return result;
 }
 
-ManifoldVector Euclidean::projection(const ManifoldPoint& x,
-                                   const ManifoldVector& etax) const {
+template <typename T>
+void Euclidean<T>::projection_into(const ManifoldPoint& x,
+                                   const ManifoldVector& etax,
+                                   ManifoldVector& out) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
     // In Euclidean space, projection is identity
-    return etax;
+    if (&out != &etax) {
+        out = etax;
+    }
 }
 
-ManifoldPoint Euclidean::retraction(const ManifoldPoint& x,
-                                   const ManifoldVector& etax) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-    // Simple addition in Euclidean space
-    return x + etax;
+template <typename T>
+void Euclidean<T>::retraction_into(const ManifoldPoint& x,
+                                   const ManifoldVector& etax,
+                                   ManifoldPoint& out) const {
+    out.set_size<T>(n, p);
+    retraction_block(x, etax, out);
 }
 
-ManifoldVector Euclidean::vector_transport(const ManifoldPoint& x,
+template <typename T>
+void Euclidean<T>::vector_transport_into(const ManifoldPoint& x,
                                          const ManifoldVector& etax,
                                          const ManifoldPoint& y,
-                                         const ManifoldVector& xix) const {
+                                         const ManifoldVector& xix,
+                                         ManifoldVector& out) const {
     check_dimensions(x, "x");
     check_dimensions(y, "y");
     check_dimensions(etax, "etax");
     check_dimensions(xix, "xix");
     // In Euclidean space, vector transport is identity
-    return xix;
+    if (&out != &xix) {
+        out = xix;
+    }
+}
+
+// The block versions work directly on the backend block views, so a
+// Euclidean factor of a product never copies its block.
+
+template <typename T>
+double Euclidean<T>::metric_block(const ConstArrayView& x,
+                                  const ConstArrayView& etax,
+                                  const ConstArrayView& xix) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(xix, "xix");
+
+    return la::inner(etax.as<T>(), xix.as<T>());
+}
+
+template <typename T>
+void Euclidean<T>::projection_block(const ConstArrayView& x,
+                                    const ConstArrayView& etax,
+                                    const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(out, "out");
+
+    out.as<T>() = etax.as<T>();
+}
+
+template <typename T>
+void Euclidean<T>::retraction_block(const ConstArrayView& x,
+                                    const ConstArrayView& etax,
+                                    const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(out, "out");
+
+    // Simple addition in Euclidean space
+    out.as<T>() = x.as<T>() + etax.as<T>();
 }
 
-} // namespace OptimLight
\ No newline at end of file
+template <typename T>
+void Euclidean<T>::vector_transport_block(const ConstArrayView& x,
+                                          const ConstArrayView& etax,
+                                          const ConstArrayView& y,
+                                          const ConstArrayView& xix,
+                                          const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(y, "y");
+    check_dimensions(etax, "etax");
+    check_dimensions(xix, "xix");
+    check_dimensions(out, "out");
+
+    out.as<T>() = xix.as<T>();
+}
+
+template <typename T>
+double Euclidean<T>::egrad_to_rgrad_block(const ConstArrayView& x,
+                                          const ConstArrayView& egrad,
+                                          const ArrayView& rgrad) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(rgrad, "rgrad");
+
+    rgrad.as<T>() = egrad.as<T>();
+    return std::sqrt(la::inner(egrad.as<T>(), egrad.as<T>()));
+}
+
+template <typename T>
+void Euclidean<T>::ehess_to_rhess_block(const ConstArrayView& x,
+                                        const ConstArrayView&,
+                                        const ConstArrayView& ehess,
+                                        const ConstArrayView&,
+                                        const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(ehess, "ehess");
+    check_dimensions(out, "out");
+
+    out.as<T>() = ehess.as<T>();
+}
+
+template class Euclidean<double>;
+template class Euclidean<la::cx_double>;
+
+} // namespace OptimLight
@@ -2,27 +2,24 @@
 #define EUCLIDEAN_HPP
 
 #include "manifold.hpp"
+#include "validation.hpp"
 
 namespace OptimLight {
 
+// n x p matrices over the scalar type T, double or la::cx_double.
+// Euclidean<double> and Euclidean<la::cx_double> are instantiated in
+// euclidean.cpp.
+template <typename T>
 class Euclidean : public Manifold {
 public:
     // Constructor for n-dimensional Euclidean space
-    explicit Euclidean(int n_, int p_, bool is_complex = false) 
-        : n(n_), p(p_), is_complex_(is_complex) {
+    explicit Euclidean(int n_, int p_) 
+        : p(p_), n(n_) {
         if (n <= 0) {
             throw std::runtime_error("Dimension must be positive");
         }
         name = "Euclidean(" + std::to_string(n) + ")";
-        empty = ManifoldVector(n, p, is_complex);
-    }
-
-    // Copy constructor
-    Euclidean(const Euclidean& other)
-        : p(other.p), n(other.n), is_complex_(other.is_complex_) 
-    {
-        name = other.name;
-        empty = other.empty;
+        empty = ManifoldVector(n, p, la::is_complex<T>::value);
     }
 
     // Manifold operations
@@ -41,6 +38,49 @@ public:
                                   const ManifoldPoint& y,
                                   const ManifoldVector& xix) const override;
 
+    void projection_into(const ManifoldPoint& x,
+                         const ManifoldVector& etax,
+                         ManifoldVector& out) const override;
+
+    void retraction_into(const ManifoldPoint& x,
+                         const ManifoldVector& etax,
+                         ManifoldPoint& out) const override;
+
+    void vector_transport_into(const ManifoldPoint& x,
+                               const ManifoldVector& etax,
+                               const ManifoldPoint& y,
+                               const ManifoldVector& xix,
+                               ManifoldVector& out) const override;
+
+    double metric_block(const ConstArrayView& x,
+                        const ConstArrayView& etax,
+                        const ConstArrayView& xix) const override;
+
+    void projection_block(const ConstArrayView& x,
+                          const ConstArrayView& etax,
+                          const ArrayView& out) const override;
+
+    void retraction_block(const ConstArrayView& x,
+                          const ConstArrayView& etax,
+                          const ArrayView& out) const override;
+
+    void vector_transport_block(const ConstArrayView& x,
+                                const ConstArrayView& etax,
+                                const ConstArrayView& y,
+                                const ConstArrayView& xix,
+                                const ArrayView& out) const override;
+
+    // The conversions are plain copies, done in place on the blocks
+    double egrad_to_rgrad_block(const ConstArrayView& x,
+                                const ConstArrayView& egrad,
+                                const ArrayView& rgrad) const override;
+
+    void ehess_to_rhess_block(const ConstArrayView& x,
+                              const ConstArrayView& egrad,
+                              const ConstArrayView& ehess,
+                              const ConstArrayView& eta,
+                              const ArrayView& out) const override;
+
     // Dimension getters
     int dimension() const override 
     { 
@@ -51,14 +91,13 @@ public:
         return n*p;
     }
 
-    bool is_complex() const { return is_complex_; }
+    bool is_complex() const { return la::is_complex<T>::value; }
 
     int p;  // Number of rows
     int n;  // Number of columns
-    bool is_complex_;
 
 private:
-    void check_dimensions(const ManifoldPoint& x, const std::string& name) const;
+    void check_dimensions(const ConstArrayView& x, const char* name) const;
 
 };
 
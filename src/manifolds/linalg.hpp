@@ -0,0 +1,35 @@
+#ifndef LINALG_HPP
+#define LINALG_HPP
+
+// Compile-time linear algebra backend. Array and the manifold kernels only
+// use the names in OptimLight::la, plus what Armadillo and Eigen spell the
+// same way: element access A(i, j), A.col(j), and the arithmetic operators
+// on matrices, views and scalars. USE_EIGEN selects Eigen, otherwise
+// Armadillo is used.
+//
+// Products written through la::noalias(out) are evaluated straight into
+// out; the destination must not overlap the operands.
+//
+// qr_econ, eig_sym, solve and expmat return false when the factorisation
+// failed, e.g. for a singular system or non-finite input; the output is
+// then unusable. Callers check the result.
+#if defined(USE_EIGEN)
+#include "linalg_eigen.hpp"
+#else
+#include "linalg_armadillo.hpp"
+#endif
+
+#include <complex>
+#include <type_traits>
+
+namespace OptimLight {
+namespace la {
+
+// Whether the scalar type T is complex
+template <typename T> struct is_complex : std::false_type {};
+template <typename T> struct is_complex<std::complex<T>> : std::true_type {};
+
+} // namespace la
+} // namespace OptimLight
+
+#endif // LINALG_HPP
@@ -0,0 +1,129 @@
+#ifndef LINALG_ARMADILLO_HPP
+#define LINALG_ARMADILLO_HPP
+
+#include <armadillo>
+#include <complex>
+
+namespace OptimLight {
+namespace la {
+
+inline const char* backend_name() { return "armadillo"; }
+
+typedef arma::uword uword;
+typedef std::complex<double> cx_double;
+
+template <typename eT> using Mat = arma::Mat<eT>;
+typedef arma::mat mat;
+typedef arma::cx_mat cx_mat;
+typedef arma::vec vec;
+
+// Views of a block of a Mat
+template <typename eT> using Block = arma::subview<eT>;
+template <typename eT> using ConstBlock = const arma::subview<eT>;
+
+namespace detail {
+template <typename eT> struct mat_ref { typedef arma::Mat<eT>& type; };
+} // namespace detail
+
+// Output argument of the kernels, binds to Mat, MapMat and PooledMat. eT is
+// never deduced from it, so the argument may be any of those.
+template <typename eT> using MatRef = typename detail::mat_ref<eT>::type;
+
+// Element type of a matrix, view or expression
+template <typename T> using elem_t = typename T::elem_type;
+
+// Fixed-size matrix over memory owned by someone else
+template <typename eT>
+class MapMat : public arma::Mat<eT> {
+public:
+    MapMat(eT* mem, uword rows, uword cols) : arma::Mat<eT>(mem, rows, cols, false, true) {}
+    MapMat(MapMat&&) = default;
+    // Copies the elements into the mapped memory
+    MapMat& operator=(const MapMat&) = default;
+
+    using arma::Mat<eT>::operator=;
+};
+
+template <typename T> uword rows(const T& A) { return A.n_rows; }
+template <typename T> uword cols(const T& A) { return A.n_cols; }
+template <typename T> uword n_elem(const T& A) { return A.n_elem; }
+
+// Address of the first element, for aliasing tests and raw kernels
+template <typename eT> eT* data(arma::Mat<eT>& A) { return A.memptr(); }
+template <typename eT> const eT* data(const arma::Mat<eT>& A) { return A.memptr(); }
+template <typename eT> const eT* data(const arma::subview<eT>& A) { return A.colptr(0); }
+
+// Block of nr x nc elements starting at (r, c)
+template <typename eT>
+Block<eT> block(arma::Mat<eT>& A, uword r, uword c, uword nr, uword nc) {
+    return A.submat(r, c, r + nr - 1, c + nc - 1);
+}
+template <typename eT>
+ConstBlock<eT> block(const arma::Mat<eT>& A, uword r, uword c, uword nr, uword nc) {
+    return A.submat(r, c, r + nr - 1, c + nc - 1);
+}
+
+// Conjugate transpose, as an expression
+template <typename T>
+auto adjoint(const T& A) -> decltype(A.t()) { return A.t(); }
+
+// Element-wise quotient, as an expression
+template <typename T1, typename T2>
+auto elem_div(const T1& A, const T2& B) -> decltype(A / B) { return A / B; }
+
+// Destination of a product that does not overlap its operands. Armadillo
+// decides this itself, so it is the matrix unchanged.
+template <typename T> T& noalias(T& A) { return A; }
+
+template <typename T> void set_zero(T&& A) { A.zeros(); }
+template <typename T> void set_identity(T&& A) { A.eye(); }
+template <typename T> void add_identity(T& A, elem_t<T> alpha) { A.diag() += alpha; }
+
+template <typename eT> void resize(arma::Mat<eT>& A, uword rows, uword cols) { A.set_size(rows, cols); }
+template <typename eT> void reset(arma::Mat<eT>& A) { A.reset(); }
+
+inline mat zeros(uword rows, uword cols) { return mat(rows, cols, arma::fill::zeros); }
+inline mat randn(uword rows, uword cols) { return mat(rows, cols, arma::fill::randn); }
+inline void set_seed(unsigned seed) { arma::arma_rng::set_seed(seed); }
+
+inline mat real(const cx_mat& A) { return mat(arma::real(A)); }
+inline mat imag(const cx_mat& A) { return mat(arma::imag(A)); }
+inline cx_mat complex(const mat& re, const mat& im) { return cx_mat(re, im); }
+inline cx_mat to_complex(const mat& A) { return cx_mat(A, arma::zeros(A.n_rows, A.n_cols)); }
+
+// sum(conj(A) % B)
+template <typename T1, typename T2>
+elem_t<T1> cdot(const T1& A, const T2& B) { return arma::cdot(A, B); }
+
+// Real part of the Frobenius inner product
+template <typename T1, typename T2>
+double inner(const T1& A, const T2& B) { return std::real(arma::cdot(A, B)); }
+
+template <typename T> double norm_fro(const T& A) { return arma::norm(A, "fro"); }
+template <typename T> double norm_inf(const T& A) { return arma::norm(A, "inf"); }
+
+template <typename T1, typename T2>
+bool approx_equal(const T1& A, const T2& B, double tol) {
+    return arma::approx_equal(A, B, "absdiff", tol);
+}
+
+// Thin QR factorisation A = Q R with Q n x p and R p x p
+template <typename eT, typename T>
+bool qr_econ(arma::Mat<eT>& Q, arma::Mat<eT>& R, const T& A) { return arma::qr_econ(Q, R, A); }
+
+// Eigenvalues d (ascending) and eigenvectors V of a Hermitian A
+template <typename eT>
+bool eig_sym(vec& d, arma::Mat<eT>& V, const arma::Mat<eT>& A) { return arma::eig_sym(d, V, A); }
+
+// X = A^{-1} B for a general square A
+template <typename eT>
+bool solve(arma::Mat<eT>& X, const arma::Mat<eT>& A, const arma::Mat<eT>& B) {
+    return arma::solve(X, A, B);
+}
+
+template <typename eT>
+bool expmat(arma::Mat<eT>& E, const arma::Mat<eT>& A) { return arma::expmat(E, A); }
+
+} // namespace la
+} // namespace OptimLight
+#endif // LINALG_ARMADILLO_HPP
@@ -0,0 +1,162 @@
+#ifndef LINALG_EIGEN_HPP
+#define LINALG_EIGEN_HPP
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/MatrixFunctions>
+#include <complex>
+#include <cstddef>
+#include <random>
+
+namespace OptimLight {
+namespace la {
+
+inline const char* backend_name() { return "eigen"; }
+
+typedef std::size_t uword;
+typedef std::complex<double> cx_double;
+
+template <typename eT> using Mat = Eigen::Matrix<eT, Eigen::Dynamic, Eigen::Dynamic>;
+typedef Mat<double> mat;
+typedef Mat<cx_double> cx_mat;
+typedef Eigen::VectorXd vec;
+
+// Views of a block of a Mat
+template <typename eT> using Block = Eigen::Block<Mat<eT>>;
+template <typename eT> using ConstBlock = Eigen::Block<const Mat<eT>>;
+
+namespace detail {
+template <typename eT> struct mat_ref { typedef Eigen::Ref<Mat<eT>> type; };
+} // namespace detail
+
+// Output argument of the kernels, binds to Mat, MapMat and PooledMat. eT is
+// never deduced from it, so the argument may be any of those.
+template <typename eT> using MatRef = typename detail::mat_ref<eT>::type;
+
+// Element type of a matrix, view or expression
+template <typename T> using elem_t = typename T::Scalar;
+
+// Fixed-size matrix over memory owned by someone else
+template <typename eT> using MapMat = Eigen::Map<Mat<eT>>;
+
+template <typename T> uword rows(const T& A) { return static_cast<uword>(A.rows()); }
+template <typename T> uword cols(const T& A) { return static_cast<uword>(A.cols()); }
+template <typename T> uword n_elem(const T& A) { return static_cast<uword>(A.size()); }
+
+// Address of the first element, for aliasing tests and raw kernels
+template <typename T> auto data(T& A) -> decltype(A.data()) { return A.data(); }
+template <typename T> auto data(const T& A) -> decltype(A.data()) { return A.data(); }
+
+// Block of nr x nc elements starting at (r, c)
+template <typename Derived>
+Eigen::Block<Derived> block(Eigen::MatrixBase<Derived>& A, uword r, uword c, uword nr, uword nc) {
+    return A.block(r, c, nr, nc);
+}
+template <typename Derived>
+Eigen::Block<const Derived> block(const Eigen::MatrixBase<Derived>& A,
+                                  uword r, uword c, uword nr, uword nc) {
+    return A.block(r, c, nr, nc);
+}
+
+// Conjugate transpose, as an expression
+template <typename T>
+auto adjoint(const T& A) -> decltype(A.adjoint()) { return A.adjoint(); }
+
+// Element-wise quotient, as an expression
+template <typename T1, typename T2>
+auto elem_div(const T1& A, const T2& B) -> decltype(A.cwiseQuotient(B)) { return A.cwiseQuotient(B); }
+
+// Destination of a product that does not overlap its operands, so Eigen
+// evaluates it in place instead of through a temporary
+template <typename T>
+auto noalias(T& A) -> decltype(A.noalias()) { return A.noalias(); }
+
+template <typename T> void set_zero(T&& A) { A.setZero(); }
+template <typename T> void set_identity(T&& A) { A.setIdentity(); }
+template <typename T> void add_identity(T& A, elem_t<T> alpha) { A.diagonal().array() += alpha; }
+
+template <typename eT> void resize(Mat<eT>& A, uword rows, uword cols) { A.resize(rows, cols); }
+template <typename eT> void reset(Mat<eT>& A) { A.resize(0, 0); }
+
+namespace detail {
+inline std::mt19937_64& engine() {
+    static thread_local std::mt19937_64 generator;
+    return generator;
+}
+} // namespace detail
+
+inline mat zeros(uword rows, uword cols) { return mat::Zero(rows, cols); }
+inline mat randn(uword rows, uword cols) {
+    std::normal_distribution<double> normal;
+    mat A(rows, cols);
+    for (Eigen::Index i = 0; i < A.size(); ++i) {
+        A.data()[i] = normal(detail::engine());
+    }
+    return A;
+}
+inline void set_seed(unsigned seed) { detail::engine().seed(seed); }
+
+inline mat real(const cx_mat& A) { return A.real(); }
+inline mat imag(const cx_mat& A) { return A.imag(); }
+inline cx_mat complex(const mat& re, const mat& im) {
+    cx_mat A(re.rows(), re.cols());
+    A.real() = re;
+    A.imag() = im;
+    return A;
+}
+inline cx_mat to_complex(const mat& A) { return A.cast<cx_double>(); }
+
+// sum(conj(A) % B)
+template <typename T1, typename T2>
+elem_t<T1> cdot(const T1& A, const T2& B) { return A.conjugate().cwiseProduct(B).sum(); }
+
+// Real part of the Frobenius inner product
+template <typename T1, typename T2>
+double inner(const T1& A, const T2& B) { return std::real(cdot(A, B)); }
+
+template <typename T> double norm_fro(const T& A) { return A.norm(); }
+template <typename T> double norm_inf(const T& A) { return A.cwiseAbs().rowwise().sum().maxCoeff(); }
+
+template <typename T1, typename T2>
+bool approx_equal(const T1& A, const T2& B, double tol) {
+    return A.size() == 0 || (A - B).cwiseAbs().maxCoeff() <= tol;
+}
+
+// Thin QR factorisation A = Q R with Q n x p and R p x p
+template <typename T>
+bool qr_econ(MatRef<elem_t<T>> Q, MatRef<elem_t<T>> R, const T& A) {
+    const Eigen::HouseholderQR<Mat<elem_t<T>>> qr(A);
+    const Eigen::Index p = A.cols();
+    R = qr.matrixQR().topRows(p).template triangularView<Eigen::Upper>();
+    Q.setIdentity();
+    qr.householderQ().applyThisOnTheLeft(Q);
+    // Householder QR has no failure mode of its own; non-finite input
+    // shows up in the factors
+    return Q.allFinite() && R.allFinite();
+}
+
+// Eigenvalues d (ascending) and eigenvectors V of a Hermitian A
+template <typename T>
+bool eig_sym(vec& d, MatRef<elem_t<T>> V, const T& A) {
+    const Eigen::SelfAdjointEigenSolver<Mat<elem_t<T>>> es(A);
+    d = es.eigenvalues();
+    V = es.eigenvectors();
+    return es.info() == Eigen::Success;
+}
+
+// X = A^{-1} B for a general square A. Partial-pivoting LU does not
+// detect singularity; a zero pivot makes X non-finite, which is reported.
+template <typename TA, typename TB>
+bool solve(MatRef<elem_t<TA>> X, const TA& A, const TB& B) {
+    X = A.partialPivLu().solve(B);
+    return X.allFinite();
+}
+
+template <typename T>
+bool expmat(MatRef<elem_t<T>> E, const T& A) {
+    E = A.exp();
+    return E.allFinite();
+}
+
+} // namespace la
+} // namespace OptimLight
+#endif // LINALG_EIGEN_HPP
@@ -1 +1,286 @@
-#include "manifold.hpp"
\ No newline at end of file
+#include "manifold.hpp"
+#include <cmath>
+
+namespace OptimLight
+{
+
+namespace {
+
+// Retracts t * etax afresh for every t
+class ScaledRetractionCurve : public RetractionCurve
+{
+public:
+    ScaledRetractionCurve(const Manifold& manifold, const ManifoldPoint& x, 
+                          const ManifoldVector& etax)
+        : manifold_(manifold), x_(x), etax_(etax) {}
+
+    void evaluate(double t, ManifoldPoint& out) const override
+    {
+        step_ = etax_;
+        step_ *= t;
+        manifold_.retraction_into(x_, step_, out);
+    }
+
+    bool reset(const Manifold& manifold, const ManifoldPoint& x, 
+               const ManifoldVector& etax) override
+    {
+        if (&manifold != &manifold_) {
+            return false;
+        }
+        x_ = x;
+        etax_ = etax;
+        return true;
+    }
+
+private:
+    const Manifold& manifold_;
+    ManifoldPoint x_;
+    ManifoldVector etax_;
+    mutable ManifoldVector step_;
+};
+
+} // namespace
+
+void RetractionCurve::evaluate_block(double t, const ArrayView& out) const
+{
+    evaluate(t, scratch_);
+    out.assign(scratch_);
+}
+
+bool RetractionCurve::reset(const Manifold&, const ManifoldPoint&, const ManifoldVector&)
+{
+    return false;
+}
+
+bool RetractionCurve::reset_block(const Manifold& manifold, const ConstArrayView& x, 
+                                  const ConstArrayView& etax)
+{
+    x.copy_to(block_x_);
+    etax.copy_to(block_etax_);
+    return reset(manifold, block_x_, block_etax_);
+}
+
+void Manifold::projection_into(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               ManifoldVector& out) const
+{
+    out = projection(x, etax);
+}
+
+void Manifold::retraction_into(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               ManifoldPoint& out) const
+{
+    out = retraction(x, etax);
+}
+
+void Manifold::vector_transport_into(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     const ManifoldPoint& y, 
+                                     const ManifoldVector& xix,
+                                     ManifoldVector& out) const
+{
+    out = vector_transport(x, etax, y, xix);
+}
+
+double Manifold::metric_block(const ConstArrayView& x, 
+                              const ConstArrayView& etax, 
+                              const ConstArrayView& xix) const
+{
+    ManifoldPoint x_blk;
+    ManifoldVector etax_blk, xix_blk;
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    xix.copy_to(xix_blk);
+    return metric(x_blk, etax_blk, xix_blk);
+}
+
+void Manifold::projection_block(const ConstArrayView& x, 
+                                const ConstArrayView& etax,
+                                const ArrayView& out) const
+{
+    ManifoldPoint x_blk;
+    ManifoldVector etax_blk, result;
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    projection_into(x_blk, etax_blk, result);
+    out.assign(result);
+}
+
+void Manifold::retraction_block(const ConstArrayView& x, 
+                                const ConstArrayView& etax,
+                                const ArrayView& out) const
+{
+    ManifoldPoint x_blk, result;
+    ManifoldVector etax_blk;
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    retraction_into(x_blk, etax_blk, result);
+    out.assign(result);
+}
+
+void Manifold::vector_transport_block(const ConstArrayView& x, 
+                                      const ConstArrayView& etax,
+                                      const ConstArrayView& y, 
+                                      const ConstArrayView& xix,
+                                      const ArrayView& out) const
+{
+    ManifoldPoint x_blk, y_blk;
+    ManifoldVector etax_blk, xix_blk, result;
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    y.copy_to(y_blk);
+    xix.copy_to(xix_blk);
+    vector_transport_into(x_blk, etax_blk, y_blk, xix_blk, result);
+    out.assign(result);
+}
+
+void Manifold::vector_transport_many(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     const ManifoldPoint& y, 
+                                     const std::vector<ManifoldVector*>& xis) const
+{
+    for (ManifoldVector* xi : xis) {
+        vector_transport_into(x, etax, y, *xi, *xi);
+    }
+}
+
+void Manifold::retract_and_transport(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     ManifoldPoint& y, 
+                                     const std::vector<ManifoldVector*>& xis) const
+{
+    retraction_into(x, etax, y);
+    vector_transport_many(x, etax, y, xis);
+}
+
+void Manifold::vector_transport_many_block(const ConstArrayView& x, 
+                                           const ConstArrayView& etax,
+                                           const ConstArrayView& y, 
+                                           const std::vector<ArrayView>& xis) const
+{
+    ManifoldPoint x_blk, y_blk;
+    ManifoldVector etax_blk;
+    std::vector<ManifoldVector> xi_blks(xis.size());
+    std::vector<ManifoldVector*> xi_ptrs(xis.size());
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    y.copy_to(y_blk);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        ConstArrayView(xis[i]).copy_to(xi_blks[i]);
+        xi_ptrs[i] = &xi_blks[i];
+    }
+    vector_transport_many(x_blk, etax_blk, y_blk, xi_ptrs);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        xis[i].assign(xi_blks[i]);
+    }
+}
+
+void Manifold::retract_and_transport_block(const ConstArrayView& x, 
+                                           const ConstArrayView& etax,
+                                           const ArrayView& y, 
+                                           const std::vector<ArrayView>& xis) const
+{
+    ManifoldPoint x_blk, y_blk;
+    ManifoldVector etax_blk;
+    std::vector<ManifoldVector> xi_blks(xis.size());
+    std::vector<ManifoldVector*> xi_ptrs(xis.size());
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        ConstArrayView(xis[i]).copy_to(xi_blks[i]);
+        xi_ptrs[i] = &xi_blks[i];
+    }
+    retract_and_transport(x_blk, etax_blk, y_blk, xi_ptrs);
+    y.assign(y_blk);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        xis[i].assign(xi_blks[i]);
+    }
+}
+
+double Manifold::egrad_to_rgrad(const ManifoldPoint& x, 
+                                const ManifoldVector& egrad,
+                                ManifoldVector& rgrad,
+                                Array* correction) const
+{
+    projection_into(x, egrad, rgrad);
+    if (correction) {
+        correction->set_size(0, 0, false);
+    }
+    return std::sqrt(metric(x, rgrad, rgrad));
+}
+
+void Manifold::ehess_to_rhess(const ManifoldPoint& x, 
+                              const ManifoldVector&,
+                              const ManifoldVector& ehess,
+                              const ManifoldVector&,
+                              ManifoldVector& out,
+                              const Array*) const
+{
+    projection_into(x, ehess, out);
+}
+
+double Manifold::egrad_to_rgrad_block(const ConstArrayView& x, 
+                                      const ConstArrayView& egrad,
+                                      const ArrayView& rgrad) const
+{
+    ManifoldPoint x_blk;
+    ManifoldVector egrad_blk;
+    x.copy_to(x_blk);
+    egrad.copy_to(egrad_blk);
+    const double norm = egrad_to_rgrad(x_blk, egrad_blk, egrad_blk);
+    rgrad.assign(egrad_blk);
+    return norm;
+}
+
+void Manifold::ehess_to_rhess_block(const ConstArrayView& x, 
+                                    const ConstArrayView& egrad,
+                                    const ConstArrayView& ehess,
+                                    const ConstArrayView& eta,
+                                    const ArrayView& out) const
+{
+    ManifoldPoint x_blk;
+    ManifoldVector egrad_blk, ehess_blk, eta_blk;
+    x.copy_to(x_blk);
+    egrad.copy_to(egrad_blk);
+    ehess.copy_to(ehess_blk);
+    eta.copy_to(eta_blk);
+    ehess_to_rhess(x_blk, egrad_blk, ehess_blk, eta_blk, ehess_blk);
+    out.assign(ehess_blk);
+}
+
+std::unique_ptr<RetractionCurve> Manifold::retraction_curve(const ManifoldPoint& x, 
+                                                            const ManifoldVector& etax) const
+{
+    return std::unique_ptr<RetractionCurve>(new ScaledRetractionCurve(*this, x, etax));
+}
+
+std::unique_ptr<RetractionCurve> Manifold::retraction_curve_block(const ConstArrayView& x, 
+                                                                  const ConstArrayView& etax) const
+{
+    ManifoldPoint x_blk;
+    ManifoldVector etax_blk;
+    x.copy_to(x_blk);
+    etax.copy_to(etax_blk);
+    return retraction_curve(x_blk, etax_blk);
+}
+
+void Manifold::retraction_curve_into(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     std::unique_ptr<RetractionCurve>& curve) const
+{
+    if (!curve || !curve->reset(*this, x, etax)) {
+        curve = retraction_curve(x, etax);
+    }
+}
+
+void Manifold::retraction_curve_block_into(const ConstArrayView& x, 
+                                           const ConstArrayView& etax,
+                                           std::unique_ptr<RetractionCurve>& curve) const
+{
+    if (!curve || !curve->reset_block(*this, x, etax)) {
+        curve = retraction_curve_block(x, etax);
+    }
+}
+
+} // namespace OptimLight
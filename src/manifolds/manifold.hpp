@@ -2,15 +2,54 @@
 #define MANIFOLD_HPP
 
 #include "array.hpp"
+#include "array_view.hpp"
+#include <memory>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <string>
+#include <vector>
 
 namespace OptimLight
 {
     using ManifoldPoint = Array;
     using ManifoldVector = Array;
+
+    // The retraction curve t -> R_x(t eta) for a fixed x and eta. A line
+    // search evaluates it at many t along the same direction, so
+    // implementations do everything that does not depend on t once, when
+    // the curve is created. The curve keeps its own copies of x and eta but
+    // may refer to the manifold that made it, which must outlive it. One
+    // curve is not meant to be evaluated by several threads at once.
+    class Manifold;
+
+    class RetractionCurve
+    {
+    public:
+        virtual ~RetractionCurve() = default;
+
+        // out = R_x(t eta)
+        virtual void evaluate(double t, ManifoldPoint& out) const = 0;
+
+        // Write R_x(t eta) into a block of a larger point. The default
+        // evaluates into a scratch point and copies it in.
+        virtual void evaluate_block(double t, const ArrayView& out) const;
+
+        // Rebind the curve to x and eta in its existing storage, see
+        // Manifold::retraction_curve_into. Returns false, and leaves the
+        // curve as it was, unless the curve was made by `manifold` and can
+        // be rebound; the default always returns false. The block version
+        // copies the blocks into storage of the curve first.
+        virtual bool reset(const Manifold& manifold, const ManifoldPoint& x,
+                           const ManifoldVector& etax);
+        bool reset_block(const Manifold& manifold, const ConstArrayView& x,
+                         const ConstArrayView& etax);
+
+    private:
+        mutable ManifoldPoint scratch_;
+        ManifoldPoint block_x_;
+        ManifoldVector block_etax_;
+    };
     
     class Manifold
     {
@@ -32,11 +71,146 @@ namespace OptimLight
                                               const ManifoldPoint& y, 
                                               const ManifoldVector& xix) const = 0;
 
+        // Output-parameter variants writing into caller-owned storage. `out`
+        // is only reshaped when its size or type differs, so reusing the same
+        // buffer across iterations keeps the manifold's own work
+        // allocation-free; a factorisation done by the backend may still
+        // allocate its workspace, see Stiefel::retraction_into, and so does
+        // the thread pool of a threaded ProductManifold or
+        // StackedManifold, see ThreadPool::run. `out` may
+        // alias the tangent vector argument but not the point(s).
+        // The defaults fall back to the by-value operations.
+        virtual void projection_into(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     ManifoldVector& out) const;
+
+        virtual void retraction_into(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax,
+                                     ManifoldPoint& out) const;
+
+        virtual void vector_transport_into(const ManifoldPoint& x, 
+                                           const ManifoldVector& etax,
+                                           const ManifoldPoint& y, 
+                                           const ManifoldVector& xix,
+                                           ManifoldVector& out) const;
+
+        // Block-level operations. ProductManifold and StackedManifold call
+        // these with views of the rows that belong to one component, so the
+        // component reads and writes its block of the larger array in place.
+        // The defaults copy the blocks out and call the Array operations.
+        virtual double metric_block(const ConstArrayView& x, 
+                                    const ConstArrayView& etax, 
+                                    const ConstArrayView& xix) const;
+
+        virtual void projection_block(const ConstArrayView& x, 
+                                      const ConstArrayView& etax,
+                                      const ArrayView& out) const;
+
+        virtual void retraction_block(const ConstArrayView& x, 
+                                      const ConstArrayView& etax,
+                                      const ArrayView& out) const;
+
+        virtual void vector_transport_block(const ConstArrayView& x, 
+                                            const ConstArrayView& etax,
+                                            const ConstArrayView& y, 
+                                            const ConstArrayView& xix,
+                                            const ArrayView& out) const;
+
+        // Transport of several tangent vectors along the same step.
+        // vector_transport_many replaces every *xis[i] by its transport
+        // from T_x to T_y, y = R_x(etax); retract_and_transport also
+        // computes y. Manifolds override them to share one factorisation
+        // between the retraction and all the transports. The vectors must
+        // not alias x, etax or y. The defaults retract and transport one
+        // vector at a time.
+        virtual void vector_transport_many(const ManifoldPoint& x, 
+                                           const ManifoldVector& etax,
+                                           const ManifoldPoint& y, 
+                                           const std::vector<ManifoldVector*>& xis) const;
+
+        virtual void retract_and_transport(const ManifoldPoint& x, 
+                                           const ManifoldVector& etax,
+                                           ManifoldPoint& y, 
+                                           const std::vector<ManifoldVector*>& xis) const;
+
+        // Block versions, for product-type manifolds. The defaults copy the
+        // blocks out and call the Array versions.
+        virtual void vector_transport_many_block(const ConstArrayView& x, 
+                                                 const ConstArrayView& etax,
+                                                 const ConstArrayView& y, 
+                                                 const std::vector<ArrayView>& xis) const;
+
+        virtual void retract_and_transport_block(const ConstArrayView& x, 
+                                                 const ConstArrayView& etax,
+                                                 const ArrayView& y, 
+                                                 const std::vector<ArrayView>& xis) const;
+
+        // Conversion of the Euclidean derivatives of f, extended to the
+        // ambient space, into Riemannian ones. egrad_to_rgrad writes the
+        // Riemannian gradient into rgrad and returns its norm in the
+        // manifold metric. If `correction` is not null it also receives the
+        // part of the Hessian conversion that depends only on x and egrad;
+        // passing it to ehess_to_rhess at the same point saves recomputing
+        // it; an empty one counts as absent. ehess_to_rhess maps
+        // ehess = D^2 f(x)[eta] to Hess f(x)[eta]. rgrad may alias egrad
+        // and out may alias ehess. The defaults
+        // project, which is exact for the Euclidean metric on a linear
+        // space; curved manifolds override them.
+        virtual double egrad_to_rgrad(const ManifoldPoint& x, 
+                                      const ManifoldVector& egrad,
+                                      ManifoldVector& rgrad,
+                                      Array* correction = nullptr) const;
+
+        virtual void ehess_to_rhess(const ManifoldPoint& x, 
+                                    const ManifoldVector& egrad,
+                                    const ManifoldVector& ehess,
+                                    const ManifoldVector& eta,
+                                    ManifoldVector& out,
+                                    const Array* correction = nullptr) const;
+
+        // Block versions of the conversions, for product-type manifolds.
+        // The defaults copy the blocks out and call the Array versions.
+        virtual double egrad_to_rgrad_block(const ConstArrayView& x, 
+                                            const ConstArrayView& egrad,
+                                            const ArrayView& rgrad) const;
+
+        virtual void ehess_to_rhess_block(const ConstArrayView& x, 
+                                          const ConstArrayView& egrad,
+                                          const ConstArrayView& ehess,
+                                          const ConstArrayView& eta,
+                                          const ArrayView& out) const;
+
+        // Curve t -> R_x(t etax) for line searches, see RetractionCurve. The
+        // defaults scale etax and retract for every t, the block version
+        // after copying the blocks out.
+        virtual std::unique_ptr<RetractionCurve> retraction_curve(const ManifoldPoint& x, 
+                                                                  const ManifoldVector& etax) const;
+
+        virtual std::unique_ptr<RetractionCurve> retraction_curve_block(const ConstArrayView& x, 
+                                                                        const ConstArrayView& etax) const;
+
+        // Make `curve` the curve of x and etax. A curve this manifold made
+        // earlier is rebound in place, so a solver that keeps one curve
+        // across its line searches allocates nothing once it is warm; any
+        // other curve, or none, is replaced by retraction_curve(x, etax).
+        virtual void retraction_curve_into(const ManifoldPoint& x, 
+                                           const ManifoldVector& etax,
+                                           std::unique_ptr<RetractionCurve>& curve) const;
+
+        virtual void retraction_curve_block_into(const ConstArrayView& x, 
+                                                 const ConstArrayView& etax,
+                                                 std::unique_ptr<RetractionCurve>& curve) const;
+
         // virtual int intrinsic_dimension() const = 0;
         // virtual int dimension() const = 0;
 
         virtual int intrinsic_dimension() const =0;
         virtual int dimension() const =0;
+
+        // Relative cost of one operation on this manifold, used to balance
+        // work across threads. Defaults to the ambient dimension.
+        virtual double cost_estimate() const { return dimension(); }
+
         std::string name; // name of the manifold
         
         ManifoldVector empty; // empty tangent vector
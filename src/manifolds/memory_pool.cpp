@@ -0,0 +1,64 @@
+#include "memory_pool.hpp"
+#include <new>
+
+namespace OptimLight {
+
+MemoryPool::~MemoryPool() {
+    clear();
+}
+
+size_t MemoryPool::bucket_index(size_t bytes) {
+    size_t index = 0;
+    size_t capacity = 64;  // smallest bucket, one cache line
+    while (capacity < bytes) {
+        capacity <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+void* MemoryPool::acquire(size_t bytes) {
+    size_t index = bucket_index(bytes);
+    if (index < free_lists_.size() && !free_lists_[index].empty()) {
+        void* ptr = free_lists_[index].back();
+        free_lists_[index].pop_back();
+        return ptr;
+    }
+    ++heap_allocations_;
+    return ::operator new(size_t(64) << index);
+}
+
+void MemoryPool::release(void* ptr, size_t bytes) {
+    if (!ptr) {
+        return;
+    }
+    size_t index = bucket_index(bytes);
+    if (index >= free_lists_.size()) {
+        free_lists_.resize(index + 1);
+    }
+    free_lists_[index].push_back(ptr);
+}
+
+void MemoryPool::clear() {
+    for (std::vector<void*>& list : free_lists_) {
+        for (void* ptr : list) {
+            ::operator delete(ptr);
+        }
+        list.clear();
+    }
+}
+
+size_t MemoryPool::cached_bytes() const {
+    size_t total = 0;
+    for (size_t i = 0; i < free_lists_.size(); ++i) {
+        total += free_lists_[i].size() * (size_t(64) << i);
+    }
+    return total;
+}
+
+MemoryPool& MemoryPool::local() {
+    thread_local MemoryPool pool;
+    return pool;
+}
+
+} // namespace OptimLight
@@ -0,0 +1,89 @@
+#ifndef MEMORY_POOL_HPP
+#define MEMORY_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include "linalg.hpp"
+
+namespace OptimLight {
+
+// Size-bucketed pool of scratch memory. Requests are rounded up to a power
+// of two and released buffers are kept on a per-bucket free list, so the
+// temporaries a kernel needs on every iteration are served without going
+// through malloc/free once the pool is warm.
+//
+// A pool is not thread-safe; use MemoryPool::local() to get the calling
+// thread's own instance.
+class MemoryPool {
+public:
+    MemoryPool() = default;
+    ~MemoryPool();
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    // Get a buffer of at least `bytes` bytes
+    void* acquire(size_t bytes);
+
+    // Give back a buffer obtained from acquire() with the same size
+    void release(void* ptr, size_t bytes);
+
+    // Free every cached buffer
+    void clear();
+
+    // Bytes currently held on the free lists
+    size_t cached_bytes() const;
+
+    // Number of buffers that had to be taken from the heap
+    size_t heap_allocations() const { return heap_allocations_; }
+
+    // Pool of the calling thread
+    static MemoryPool& local();
+
+private:
+    static size_t bucket_index(size_t bytes);
+
+    std::vector<std::vector<void*>> free_lists_;
+    size_t heap_allocations_ = 0;
+};
+
+namespace detail {
+
+// Holds the pooled buffer so it is acquired before the la::MapMat base of
+// PooledMat is constructed on top of it.
+template <typename eT>
+class PooledBuffer {
+protected:
+    PooledBuffer(size_t n_elem)
+        : pool_(MemoryPool::local()),
+          bytes_((n_elem > 0 ? n_elem : 1) * sizeof(eT)),
+          mem_(static_cast<eT*>(pool_.acquire(bytes_))) {}
+
+    ~PooledBuffer() { pool_.release(mem_, bytes_); }
+
+    MemoryPool& pool_;
+    size_t bytes_;
+    eT* mem_;
+};
+
+} // namespace detail
+
+// Fixed-size backend matrix whose memory comes from the thread's
+// MemoryPool and goes back to it on destruction. Like any la::MapMat it
+// cannot be resized, so every expression assigned to it has to match its
+// dimensions.
+template <typename eT>
+class PooledMat : private detail::PooledBuffer<eT>, public la::MapMat<eT> {
+public:
+    PooledMat(la::uword rows, la::uword cols)
+        : detail::PooledBuffer<eT>(rows * cols),
+          la::MapMat<eT>(this->mem_, rows, cols) {}
+
+    PooledMat(const PooledMat&) = delete;
+    PooledMat& operator=(const PooledMat&) = delete;
+
+    using la::MapMat<eT>::operator=;
+};
+
+} // namespace OptimLight
+#endif // MEMORY_POOL_HPP
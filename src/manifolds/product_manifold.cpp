@@ -1,10 +1,219 @@
 #include "product_manifold.hpp"
+#include <cmath>
 #include <stdexcept>
 #include <numeric>
 #include <sstream>
+#include <algorithm>
+#include <deque>
 
 namespace OptimLight {
 
+namespace {
+
+// Per-thread storage for ProductManifold::component_blocks, so that the
+// batched transports do not allocate once it has grown. A component task
+// opens a level for its views; a product nested inside the component
+// opens the next one instead of overwriting them. A deque keeps the outer
+// levels in place while it grows.
+class BlockViews {
+public:
+    BlockViews() {
+        Stack& stack = stack_();
+        if (stack.depth == stack.levels.size()) {
+            stack.levels.emplace_back();
+        }
+        ++stack.depth;
+    }
+    ~BlockViews() { --stack_().depth; }
+
+    BlockViews(const BlockViews&) = delete;
+    BlockViews& operator=(const BlockViews&) = delete;
+
+    // The views of the innermost open level
+    static std::vector<ArrayView>& current() {
+        Stack& stack = stack_();
+        return stack.levels[stack.depth - 1];
+    }
+
+private:
+    struct Stack {
+        std::deque<std::vector<ArrayView>> levels;
+        size_t depth = 0;
+    };
+
+    static Stack& stack_() {
+        thread_local Stack stack;
+        return stack;
+    }
+};
+
+// Real part of a, or a itself if it is real
+Array real_part(const Array& a) {
+    return a.is_complex() ? Array(la::real(a.as_cx_mat())) : a;
+}
+
+Array real_part(const ConstArrayView& v) {
+    Array a;
+    v.copy_to(a);
+    return real_part(a);
+}
+
+// a as a complex Array, with zero imaginary part if it is real
+Array to_complex(const Array& a) {
+    return a.is_complex() ? a : Array(la::to_complex(a.as_mat()));
+}
+
+} // namespace
+
+// Stands in for a real manifold in a complex product. The blocks of the
+// component arrive complex; it passes their real parts to the manifold and
+// writes the results back with zero imaginary parts. The tangent vectors of
+// a real manifold are real, so dropping the imaginary part of an ambient
+// vector is part of projecting it. Every call copies the blocks.
+class ProductManifold::RealComponent : public Manifold {
+public:
+    explicit RealComponent(const Manifold* base) : base_(base) {
+        name = base->name;
+        empty = ManifoldVector(base->empty.n_rows(), base->empty.n_cols(), true);
+    }
+
+    double metric(const ManifoldPoint& x, const ManifoldVector& etax,
+                  const ManifoldVector& xix) const override {
+        return base_->metric(real_part(x), real_part(etax), real_part(xix));
+    }
+
+    ManifoldVector projection(const ManifoldPoint& x,
+                              const ManifoldVector& etax) const override {
+        return to_complex(base_->projection(real_part(x), real_part(etax)));
+    }
+
+    ManifoldPoint retraction(const ManifoldPoint& x,
+                             const ManifoldVector& etax) const override {
+        return to_complex(base_->retraction(real_part(x), real_part(etax)));
+    }
+
+    ManifoldVector vector_transport(const ManifoldPoint& x, const ManifoldVector& etax,
+                                    const ManifoldPoint& y,
+                                    const ManifoldVector& xix) const override {
+        return to_complex(base_->vector_transport(real_part(x), real_part(etax),
+                                                  real_part(y), real_part(xix)));
+    }
+
+    double metric_block(const ConstArrayView& x, const ConstArrayView& etax,
+                        const ConstArrayView& xix) const override {
+        return base_->metric(real_part(x), real_part(etax), real_part(xix));
+    }
+
+    void projection_block(const ConstArrayView& x, const ConstArrayView& etax,
+                          const ArrayView& out) const override {
+        ManifoldVector result;
+        base_->projection_into(real_part(x), real_part(etax), result);
+        out.assign(to_complex(result));
+    }
+
+    void retraction_block(const ConstArrayView& x, const ConstArrayView& etax,
+                          const ArrayView& out) const override {
+        ManifoldPoint result;
+        base_->retraction_into(real_part(x), real_part(etax), result);
+        out.assign(to_complex(result));
+    }
+
+    void vector_transport_block(const ConstArrayView& x, const ConstArrayView& etax,
+                                const ConstArrayView& y, const ConstArrayView& xix,
+                                const ArrayView& out) const override {
+        ManifoldVector result;
+        base_->vector_transport_into(real_part(x), real_part(etax), real_part(y),
+                                     real_part(xix), result);
+        out.assign(to_complex(result));
+    }
+
+    void vector_transport_many_block(const ConstArrayView& x, const ConstArrayView& etax,
+                                     const ConstArrayView& y,
+                                     const std::vector<ArrayView>& xis) const override {
+        std::vector<ManifoldVector> blks;
+        std::vector<ManifoldVector*> ptrs;
+        real_parts(xis, blks, ptrs);
+        base_->vector_transport_many(real_part(x), real_part(etax), real_part(y), ptrs);
+        for (size_t i = 0; i < xis.size(); ++i) {
+            xis[i].assign(to_complex(blks[i]));
+        }
+    }
+
+    void retract_and_transport_block(const ConstArrayView& x, const ConstArrayView& etax,
+                                     const ArrayView& y,
+                                     const std::vector<ArrayView>& xis) const override {
+        std::vector<ManifoldVector> blks;
+        std::vector<ManifoldVector*> ptrs;
+        real_parts(xis, blks, ptrs);
+        ManifoldPoint y_blk;
+        base_->retract_and_transport(real_part(x), real_part(etax), y_blk, ptrs);
+        y.assign(to_complex(y_blk));
+        for (size_t i = 0; i < xis.size(); ++i) {
+            xis[i].assign(to_complex(blks[i]));
+        }
+    }
+
+    double egrad_to_rgrad_block(const ConstArrayView& x, const ConstArrayView& egrad,
+                                const ArrayView& rgrad) const override {
+        ManifoldVector result;
+        const double norm = base_->egrad_to_rgrad(real_part(x), real_part(egrad), result);
+        rgrad.assign(to_complex(result));
+        return norm;
+    }
+
+    void ehess_to_rhess_block(const ConstArrayView& x, const ConstArrayView& egrad,
+                              const ConstArrayView& ehess, const ConstArrayView& eta,
+                              const ArrayView& out) const override {
+        ManifoldVector result;
+        base_->ehess_to_rhess(real_part(x), real_part(egrad), real_part(ehess),
+                              real_part(eta), result);
+        out.assign(to_complex(result));
+    }
+
+    std::unique_ptr<RetractionCurve> retraction_curve_block(const ConstArrayView& x,
+                                                            const ConstArrayView& etax) const override {
+        return std::unique_ptr<RetractionCurve>(
+            new ComplexCurve(base_->retraction_curve(real_part(x), real_part(etax))));
+    }
+
+    int intrinsic_dimension() const override { return base_->intrinsic_dimension(); }
+    int dimension() const override { return base_->dimension(); }
+    double cost_estimate() const override { return base_->cost_estimate(); }
+
+private:
+    // The real manifold's curve, evaluated into complex outputs
+    class ComplexCurve : public RetractionCurve {
+    public:
+        explicit ComplexCurve(std::unique_ptr<RetractionCurve> base) : base_(std::move(base)) {}
+
+        void evaluate(double t, ManifoldPoint& out) const override {
+            base_->evaluate(t, point_);
+            out = to_complex(point_);
+        }
+
+        void evaluate_block(double t, const ArrayView& out) const override {
+            base_->evaluate(t, point_);
+            out.assign(to_complex(point_));
+        }
+
+    private:
+        std::unique_ptr<RetractionCurve> base_;
+        mutable ManifoldPoint point_;
+    };
+
+    static void real_parts(const std::vector<ArrayView>& xis, std::vector<ManifoldVector>& blks,
+                           std::vector<ManifoldVector*>& ptrs) {
+        blks.resize(xis.size());
+        ptrs.resize(xis.size());
+        for (size_t i = 0; i < xis.size(); ++i) {
+            blks[i] = real_part(ConstArrayView(xis[i]));
+            ptrs[i] = &blks[i];
+        }
+    }
+
+    const Manifold* base_;
+};
+
 ProductManifold::ProductManifold()
     : manifolds(nullptr), numoftypes(0), numoftotalmani(0) {
     name = "ProductManifold";
@@ -71,13 +280,42 @@ void ProductManifold::initialize(const std::vector<const Manifold*>& base_manifo
     bool is_complex = false;
     size_t cols = base_manifolds[0]->empty.n_cols();
 
+    // Row offset of every component, so block lookups don't rescan the
+    // preceding types on each call
+    row_offsets.resize(numoftotalmani + 1);
     for (int i = 0; i < numoftypes; ++i) {
         if (base_manifolds[i]->empty.n_cols() != cols) {
             throw std::runtime_error("All manifolds must have same number of columns");
         }
-        total_rows += base_manifolds[i]->empty.n_rows() * powers[i];
+        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
+            row_offsets[j] = static_cast<int>(total_rows);
+            total_rows += base_manifolds[i]->empty.n_rows();
+        }
         is_complex = is_complex || base_manifolds[i]->empty.is_complex();
     }
+    row_offsets[numoftotalmani] = static_cast<int>(total_rows);
+
+    // In a complex product the real manifolds work through adapters
+    for (int i = 0; i < numoftypes && is_complex; ++i) {
+        if (!base_manifolds[i]->empty.is_complex()) {
+            real_adapters.push_back(std::make_shared<RealComponent>(base_manifolds[i]));
+            manifolds[i] = const_cast<Manifold*>(real_adapters.back().get());
+        }
+    }
+
+    // Component types and the parallel schedule, most expensive first
+    comp_types.resize(numoftotalmani);
+    schedule.resize(numoftotalmani);
+    for (int i = 0; i < numoftypes; ++i) {
+        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
+            comp_types[j] = i;
+            schedule[j] = j;
+        }
+    }
+    std::stable_sort(schedule.begin(), schedule.end(), [this](size_t a, size_t b) {
+        return manifolds[comp_types[a]]->cost_estimate() >
+               manifolds[comp_types[b]]->cost_estimate();
+    });
 
     empty = ManifoldVector(total_rows, cols, is_complex);
 
@@ -102,6 +340,11 @@ void ProductManifold::cleanup() {
     manifolds = nullptr;
     numoftypes = 0;
     powsinterval.clear();
+    row_offsets.clear();
+    comp_types.clear();
+    schedule.clear();
+    real_adapters.clear();
+    pool.reset();
     numoftotalmani = 0;
 }
 
@@ -109,6 +352,11 @@ void ProductManifold::copy_from(const ProductManifold& other) {
     numoftypes = other.numoftypes;
     numoftotalmani = other.numoftotalmani;
     powsinterval = other.powsinterval;
+    row_offsets = other.row_offsets;
+    comp_types = other.comp_types;
+    schedule = other.schedule;
+    real_adapters = other.real_adapters;
+    pool = other.pool;
     name = other.name;
     empty = other.empty;
 
@@ -118,38 +366,58 @@ void ProductManifold::copy_from(const ProductManifold& other) {
     }
 }
 
-// Change from auto to explicit pair
-std::pair<int, int> ProductManifold::get_manifold_dimensions(int type_idx) const {
-    if (type_idx < 0 || type_idx >= numoftypes) {
-        throw std::out_of_range("Invalid manifold type index");
+void ProductManifold::set_num_threads(int num_threads) {
+    if (num_threads > 1) {
+        pool = std::make_shared<ThreadPool>(num_threads);
+    } else {
+        pool.reset();
     }
-    return std::make_pair(manifolds[type_idx]->empty.n_rows(),
-                         manifolds[type_idx]->empty.n_cols());
 }
 
-ManifoldPoint ProductManifold::extract_submanifold(const ManifoldPoint& x,
-                                                 int type_idx,
-                                                 int copy_idx) const {
-    // Explicitly declare the pair components
-    std::pair<int, int> dims = get_manifold_dimensions(type_idx);
-    int rows = dims.first;
-    int cols = dims.second;
-    int start_row = 0;
-    
-    // Calculate starting row for this submanifold
-    for (int i = 0; i < type_idx; ++i) {
-        std::pair<int, int> mani_dims = get_manifold_dimensions(i);
-        start_row += mani_dims.first * (powsinterval[i + 1] - powsinterval[i]);
+int ProductManifold::get_num_threads() const {
+    return pool ? static_cast<int>(pool->size()) : 1;
+}
+
+template <typename F>
+void ProductManifold::for_each_component(F f) const {
+    if (pool && numoftotalmani > 1) {
+        pool->run(schedule, [&](size_t j) { f(comp_types[j], static_cast<int>(j)); });
+    } else {
+        for (int j = 0; j < numoftotalmani; ++j) {
+            f(comp_types[j], j);
+        }
     }
-    start_row += rows * copy_idx;
-    
-    return x.submat(start_row, 0, start_row + rows - 1, cols - 1);
+}
+
+ConstArrayView ProductManifold::component_block(const Array& x, int type_idx,
+                                                int comp_idx) const {
+    return ConstArrayView(x, row_offsets[comp_idx], 0,
+                          manifolds[type_idx]->empty.n_rows(),
+                          manifolds[type_idx]->empty.n_cols());
+}
+
+ArrayView ProductManifold::component_block(Array& x, int type_idx,
+                                           int comp_idx) const {
+    return ArrayView(x, row_offsets[comp_idx], 0,
+                     manifolds[type_idx]->empty.n_rows(),
+                     manifolds[type_idx]->empty.n_cols());
+}
+
+const std::vector<ArrayView>& ProductManifold::component_blocks(
+    const std::vector<ManifoldVector*>& xis, int type_idx, int comp_idx) const {
+    std::vector<ArrayView>& views = BlockViews::current();
+    views.clear();
+    for (ManifoldVector* xi : xis) {
+        views.push_back(component_block(*xi, type_idx, comp_idx));
+    }
+    return views;
 }
 
 void ProductManifold::check_dimensions(const ManifoldPoint& x,
-                                     const std::string& name) const {
+                                     const char* name) const {
+    if (!validation::dimensions_enabled) return;
     if (x.n_rows() != empty.n_rows() || x.n_cols() != empty.n_cols()) {
-        throw std::runtime_error(name + " has wrong dimensions. Expected " + 
+        throw std::runtime_error(std::string(name) + " has wrong dimensions. Expected " + 
                                std::to_string(empty.n_rows()) + "x" + 
                                std::to_string(empty.n_cols()) + ", got " +
                                std::to_string(x.n_rows()) + "x" + 
@@ -157,6 +425,8 @@ void ProductManifold::check_dimensions(const ManifoldPoint& x,
     }
 }
 
+// The component metrics are summed in component order whether or not they
+// were computed in parallel, so the result does not depend on scheduling.
 double ProductManifold::metric(const ManifoldPoint& x,
                              const ManifoldVector& etax,
                              const ManifoldVector& xix) const {
@@ -164,90 +434,255 @@ double ProductManifold::metric(const ManifoldPoint& x,
     check_dimensions(etax, "etax");
     check_dimensions(xix, "xix");
 
-    double sum = 0.0;
-    for (int i = 0; i < numoftypes; ++i) {
-        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
-            ManifoldPoint x_sub = extract_submanifold(x, i, j - powsinterval[i]);
-            ManifoldVector etax_sub = extract_submanifold(etax, i, j - powsinterval[i]);
-            ManifoldVector xix_sub = extract_submanifold(xix, i, j - powsinterval[i]);
-            sum += manifolds[i]->metric(x_sub, etax_sub, xix_sub);
+    if (!pool) {
+        double sum = 0.0;
+        for (int j = 0; j < numoftotalmani; ++j) {
+            int i = comp_types[j];
+            sum += manifolds[i]->metric_block(component_block(x, i, j),
+                                              component_block(etax, i, j),
+                                              component_block(xix, i, j));
         }
+        return sum;
+    }
+
+    std::vector<double> partial(numoftotalmani);
+    for_each_component([&](int i, int j) {
+        partial[j] = manifolds[i]->metric_block(component_block(x, i, j),
+                                                component_block(etax, i, j),
+                                                component_block(xix, i, j));
+    });
+    double sum = 0.0;
+    for (int j = 0; j < numoftotalmani; ++j) {
+        sum += partial[j];
     }
     return sum;
 }
 
-// In other methods, replace auto with explicit types
 ManifoldVector ProductManifold::projection(const ManifoldPoint& x,
                                          const ManifoldVector& etax) const {
+    ManifoldVector result;
+    projection_into(x, etax, result);
+    return result;
+}
+
+ManifoldPoint ProductManifold::retraction(const ManifoldPoint& x,
+                                        const ManifoldVector& etax) const {
+    ManifoldPoint result;
+    retraction_into(x, etax, result);
+    return result;
+}
+
+ManifoldVector ProductManifold::vector_transport(const ManifoldPoint& x,
+                                               const ManifoldVector& etax,
+                                               const ManifoldPoint& y,
+                                               const ManifoldVector& xix) const {
+    ManifoldVector result;
+    vector_transport_into(x, etax, y, xix, result);
+    return result;
+}
+
+// Each component reads its rows of the inputs and writes its rows of `out`
+// through views, so the blocks are never gathered into separate arrays and
+// components running on different threads never touch the same rows.
+void ProductManifold::projection_into(const ManifoldPoint& x,
+                                      const ManifoldVector& etax,
+                                      ManifoldVector& out) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
 
-    ManifoldVector result(empty.n_rows(), empty.n_cols(), empty.is_complex());
-    int current_row = 0;
+    out.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    for_each_component([&](int i, int j) {
+        manifolds[i]->projection_block(component_block(x, i, j),
+                                       component_block(etax, i, j),
+                                       component_block(out, i, j));
+    });
+}
 
-    for (int i = 0; i < numoftypes; ++i) {
-        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
-            ManifoldPoint x_sub = extract_submanifold(x, i, j - powsinterval[i]);
-            ManifoldVector etax_sub = extract_submanifold(etax, i, j - powsinterval[i]);
-            
-            ManifoldVector proj = manifolds[i]->projection(x_sub, etax_sub);
-            std::pair<int, int> dims = get_manifold_dimensions(i);
-            result.submat(current_row, 0, current_row + dims.first - 1, dims.second - 1) = proj;
-            current_row += dims.first;
-        }
+void ProductManifold::retraction_into(const ManifoldPoint& x,
+                                      const ManifoldVector& etax,
+                                      ManifoldPoint& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+
+    out.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    for_each_component([&](int i, int j) {
+        manifolds[i]->retraction_block(component_block(x, i, j),
+                                       component_block(etax, i, j),
+                                       component_block(out, i, j));
+    });
+}
+
+void ProductManifold::vector_transport_many(const ManifoldPoint& x,
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y,
+                                            const std::vector<ManifoldVector*>& xis) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(y, "y");
+    for (const ManifoldVector* xi : xis) {
+        check_dimensions(*xi, "xi");
     }
-    return result;
+
+    for_each_component([&](int i, int j) {
+        BlockViews level;
+        manifolds[i]->vector_transport_many_block(component_block(x, i, j),
+                                                  component_block(etax, i, j),
+                                                  component_block(y, i, j),
+                                                  component_blocks(xis, i, j));
+    });
 }
 
-ManifoldPoint ProductManifold::retraction(const ManifoldPoint& x,
-                                        const ManifoldVector& etax) const {
+void ProductManifold::retract_and_transport(const ManifoldPoint& x,
+                                            const ManifoldVector& etax,
+                                            ManifoldPoint& y,
+                                            const std::vector<ManifoldVector*>& xis) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
+    for (const ManifoldVector* xi : xis) {
+        check_dimensions(*xi, "xi");
+    }
 
-    ManifoldPoint result(empty.n_rows(), empty.n_cols(), empty.is_complex());
-    int current_row = 0;
+    y.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    for_each_component([&](int i, int j) {
+        BlockViews level;
+        manifolds[i]->retract_and_transport_block(component_block(x, i, j),
+                                                  component_block(etax, i, j),
+                                                  component_block(y, i, j),
+                                                  component_blocks(xis, i, j));
+    });
+}
 
-    for (int i = 0; i < numoftypes; ++i) {
-        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
-            ManifoldPoint x_sub = extract_submanifold(x, i, j - powsinterval[i]);
-            ManifoldVector etax_sub = extract_submanifold(etax, i, j - powsinterval[i]);
-            
-            ManifoldPoint retr = manifolds[i]->retraction(x_sub, etax_sub);
-            std::pair<int, int> dims = get_manifold_dimensions(i);
-            result.submat(current_row, 0, current_row + dims.first - 1, dims.second - 1) = retr;
-            current_row += dims.first;
+class ProductManifold::Curve : public RetractionCurve {
+public:
+    Curve(const ProductManifold& manifold, const ManifoldPoint& x, const ManifoldVector& etax)
+        : manifold_(manifold), curves_(manifold.numoftotalmani) {
+        bind(x, etax);
+    }
+
+    // The component curves are rebound in place where they can be
+    bool reset(const Manifold& manifold, const ManifoldPoint& x,
+               const ManifoldVector& etax) override {
+        if (&manifold != &manifold_) {
+            return false;
         }
+        bind(x, etax);
+        return true;
     }
-    return result;
+
+    void evaluate(double t, ManifoldPoint& out) const override {
+        out.set_size(manifold_.empty.n_rows(), manifold_.empty.n_cols(),
+                     manifold_.empty.is_complex());
+        manifold_.for_each_component([&](int i, int j) {
+            curves_[j]->evaluate_block(t, manifold_.component_block(out, i, j));
+        });
+    }
+
+private:
+    const ProductManifold& manifold_;
+    std::vector<std::unique_ptr<RetractionCurve>> curves_; // One per component
+
+    void bind(const ManifoldPoint& x, const ManifoldVector& etax) {
+        manifold_.for_each_component([&](int i, int j) {
+            manifold_.manifolds[i]->retraction_curve_block_into(
+                manifold_.component_block(x, i, j), manifold_.component_block(etax, i, j),
+                curves_[j]);
+        });
+    }
+};
+
+std::unique_ptr<RetractionCurve> ProductManifold::retraction_curve(const ManifoldPoint& x,
+                                                                   const ManifoldVector& etax) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+
+    return std::unique_ptr<RetractionCurve>(new Curve(*this, x, etax));
 }
 
-ManifoldVector ProductManifold::vector_transport(const ManifoldPoint& x,
-                                               const ManifoldVector& etax,
-                                               const ManifoldPoint& y,
-                                               const ManifoldVector& xix) const {
+void ProductManifold::retraction_curve_into(const ManifoldPoint& x,
+                                            const ManifoldVector& etax,
+                                            std::unique_ptr<RetractionCurve>& curve) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+
+    Manifold::retraction_curve_into(x, etax, curve);
+}
+
+void ProductManifold::vector_transport_into(const ManifoldPoint& x,
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y,
+                                            const ManifoldVector& xix,
+                                            ManifoldVector& out) const {
     check_dimensions(x, "x");
     check_dimensions(y, "y");
     check_dimensions(etax, "etax");
     check_dimensions(xix, "xix");
 
-    ManifoldVector result(empty.n_rows(), empty.n_cols(), empty.is_complex());
-    int current_row = 0;
+    out.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    for_each_component([&](int i, int j) {
+        manifolds[i]->vector_transport_block(component_block(x, i, j),
+                                             component_block(etax, i, j),
+                                             component_block(y, i, j),
+                                             component_block(xix, i, j),
+                                             component_block(out, i, j));
+    });
+}
 
-    for (int i = 0; i < numoftypes; ++i) {
-        for (int j = powsinterval[i]; j < powsinterval[i + 1]; ++j) {
-            ManifoldPoint x_sub = extract_submanifold(x, i, j - powsinterval[i]);
-            ManifoldPoint y_sub = extract_submanifold(y, i, j - powsinterval[i]);
-            ManifoldVector etax_sub = extract_submanifold(etax, i, j - powsinterval[i]);
-            ManifoldVector xix_sub = extract_submanifold(xix, i, j - powsinterval[i]);
-            
-            ManifoldVector trans = manifolds[i]->vector_transport(x_sub, etax_sub,
-                                                                y_sub, xix_sub);
-            std::pair<int, int> dims = get_manifold_dimensions(i);
-            result.submat(current_row, 0, current_row + dims.first - 1, dims.second - 1) = trans;
-            current_row += dims.first;
+double ProductManifold::egrad_to_rgrad(const ManifoldPoint& x,
+                                      const ManifoldVector& egrad,
+                                      ManifoldVector& rgrad,
+                                      Array* correction) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+
+    rgrad.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    if (correction) {
+        correction->set_size(0, 0, false);
+    }
+    if (!pool) {
+        double sum = 0.0;
+        for (int j = 0; j < numoftotalmani; ++j) {
+            int i = comp_types[j];
+            const double norm = manifolds[i]->egrad_to_rgrad_block(component_block(x, i, j),
+                                                                   component_block(egrad, i, j),
+                                                                   component_block(rgrad, i, j));
+            sum += norm * norm;
         }
+        return std::sqrt(sum);
     }
-    return result;
+
+    std::vector<double> partial(numoftotalmani);
+    for_each_component([&](int i, int j) {
+        const double norm = manifolds[i]->egrad_to_rgrad_block(component_block(x, i, j),
+                                                               component_block(egrad, i, j),
+                                                               component_block(rgrad, i, j));
+        partial[j] = norm * norm;
+    });
+    double sum = 0.0;
+    for (int j = 0; j < numoftotalmani; ++j) {
+        sum += partial[j];
+    }
+    return std::sqrt(sum);
+}
+
+void ProductManifold::ehess_to_rhess(const ManifoldPoint& x,
+                                     const ManifoldVector& egrad,
+                                     const ManifoldVector& ehess,
+                                     const ManifoldVector& eta,
+                                     ManifoldVector& out,
+                                     const Array*) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(ehess, "ehess");
+    check_dimensions(eta, "eta");
+
+    out.set_size(empty.n_rows(), empty.n_cols(), empty.is_complex());
+    for_each_component([&](int i, int j) {
+        manifolds[i]->ehess_to_rhess_block(component_block(x, i, j),
+                                           component_block(egrad, i, j),
+                                           component_block(ehess, i, j),
+                                           component_block(eta, i, j),
+                                           component_block(out, i, j));
+    });
 }
 
 int ProductManifold::dimension() const {
@@ -268,4 +703,13 @@ int ProductManifold::intrinsic_dimension() const {
     return dim;
 }
 
+double ProductManifold::cost_estimate() const {
+    double cost = 0.0;
+    for (int i = 0; i < numoftypes; ++i) {
+        cost += manifolds[i]->cost_estimate() * 
+                (powsinterval[i + 1] - powsinterval[i]);
+    }
+    return cost;
+}
+
 } // namespace OptimLight
\ No newline at end of file
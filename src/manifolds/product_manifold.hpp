@@ -2,10 +2,18 @@
 #define PRODUCT_MANIFOLD_HPP
 
 #include "manifold.hpp"
+#include "validation.hpp"
+#include "thread_pool.hpp"
+#include <memory>
 #include <vector>
 
 namespace OptimLight {
 
+// Product of manifolds whose points are stacked vertically, component j in
+// rows [row_offsets[j], row_offsets[j + 1]). Real and complex manifolds can
+// be mixed: the product is complex if any of them is, and the real ones
+// then see the real parts of their blocks, see RealComponent in
+// product_manifold.cpp.
 class ProductManifold : public Manifold {
 public:
     // Default constructor
@@ -38,27 +46,104 @@ public:
                                   const ManifoldPoint& y, 
                                   const ManifoldVector& xix) const override;
 
+    void projection_into(const ManifoldPoint& x, 
+                         const ManifoldVector& etax,
+                         ManifoldVector& out) const override;
+
+    void retraction_into(const ManifoldPoint& x, 
+                         const ManifoldVector& etax,
+                         ManifoldPoint& out) const override;
+
+    void vector_transport_into(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               const ManifoldPoint& y, 
+                               const ManifoldVector& xix,
+                               ManifoldVector& out) const override;
+
+    // Every component transports its blocks of all the vectors in one
+    // call, so a Stiefel component shares its factorisations across them
+    void vector_transport_many(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               const ManifoldPoint& y, 
+                               const std::vector<ManifoldVector*>& xis) const override;
+
+    void retract_and_transport(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               ManifoldPoint& y, 
+                               const std::vector<ManifoldVector*>& xis) const override;
+
+    // Combines the curves of the components, which are created, rebound
+    // and evaluated on the pool like the other operations
+    std::unique_ptr<RetractionCurve> retraction_curve(const ManifoldPoint& x, 
+                                                      const ManifoldVector& etax) const override;
+    void retraction_curve_into(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               std::unique_ptr<RetractionCurve>& curve) const override;
+
+    // Convert block by block through the components. The components keep
+    // no per-point correction, so `correction` is left empty.
+    double egrad_to_rgrad(const ManifoldPoint& x, 
+                          const ManifoldVector& egrad,
+                          ManifoldVector& rgrad,
+                          Array* correction = nullptr) const override;
+
+    void ehess_to_rhess(const ManifoldPoint& x, 
+                        const ManifoldVector& egrad,
+                        const ManifoldVector& ehess,
+                        const ManifoldVector& eta,
+                        ManifoldVector& out,
+                        const Array* correction = nullptr) const override;
+
     // Dimension calculations
     virtual int dimension() const ;
     virtual int intrinsic_dimension() const ;
+    double cost_estimate() const override;
+
+    // Run the component operations on a pool of num_threads threads (the
+    // caller included), largest components first. 1 or less runs them
+    // sequentially on the calling thread. Copies share the pool; an
+    // operation that finds it busy runs inline, see ThreadPool::run, which
+    // also allocates on every call, so a threaded product is not
+    // allocation-free.
+    void set_num_threads(int num_threads);
+    int get_num_threads() const;
 
 protected:
     Manifold** manifolds;        // Store all kinds of manifolds
     int numoftypes;              // Number of kinds of manifolds
     std::vector<int> powsinterval; // Manifold intervals
+    std::vector<int> row_offsets;  // First row of each component, plus the total
+    std::vector<int> comp_types;   // Manifold type of each component
+    std::vector<size_t> schedule;  // Components by decreasing cost_estimate()
+    std::shared_ptr<ThreadPool> pool; // Null for sequential execution
     int numoftotalmani;          // Total number of manifolds
+    // Adapters standing in for the real manifolds of a complex product,
+    // shared by copies
+    std::vector<std::shared_ptr<const Manifold>> real_adapters;
 
 private:
+    class Curve;
+    class RealComponent;
+
     // Helper functions
     void initialize(const std::vector<const Manifold*>& base_manifolds,
                    const std::vector<int>& powers);
     void cleanup();
     void copy_from(const ProductManifold& other);
     
-    // Manifold extraction helpers
-    ManifoldPoint extract_submanifold(const ManifoldPoint& x, int type_idx, int copy_idx) const;
-    std::pair<int, int> get_manifold_dimensions(int type_idx) const;
-    void check_dimensions(const ManifoldPoint& x, const std::string& name) const;
+    // Call f(type_idx, comp_idx) for every component, on the pool if set
+    template <typename F>
+    void for_each_component(F f) const;
+
+    // Views of component comp_idx (of manifold type type_idx) inside x
+    ConstArrayView component_block(const Array& x, int type_idx, int comp_idx) const;
+    ArrayView component_block(Array& x, int type_idx, int comp_idx) const;
+    // Views of component comp_idx inside each of the vectors, in storage
+    // kept per thread (see BlockViews in product_manifold.cpp), valid until
+    // the calling task returns
+    const std::vector<ArrayView>& component_blocks(const std::vector<ManifoldVector*>& xis,
+                                                   int type_idx, int comp_idx) const;
+    void check_dimensions(const ManifoldPoint& x, const char* name) const;
 };
 
 } // namespace OptimLight
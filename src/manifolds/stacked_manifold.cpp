@@ -1,30 +1,87 @@
 #include "stacked_manifold.hpp"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace OptimLight {
 
+const int StackedManifold::chunk_size;
+
 void StackedManifold::check_dimensions(const ManifoldPoint& x, 
-                                     const std::string& name) const {
-    int expected_rows = base_->empty.n_rows() * num_copies_;
-    if (x.n_rows() != expected_rows) {
-        throw std::runtime_error(name + " dimension mismatch. Expected " + 
-                               std::to_string(expected_rows) + " rows, got " + 
-                               std::to_string(x.n_rows()));
+                                     const char* name) const {
+    if (!validation::dimensions_enabled) return;
+    if (x.n_rows() != empty.n_rows() || x.n_cols() != empty.n_cols()) {
+        throw std::runtime_error(std::string(name) + " dimension mismatch. Expected " + 
+                               std::to_string(empty.n_rows()) + "x" + 
+                               std::to_string(empty.n_cols()) + ", got " +
+                               std::to_string(x.n_rows()) + "x" + 
+                               std::to_string(x.n_cols()));
     }
 }
 
-ManifoldPoint StackedManifold::extract_submanifold(const ManifoldPoint& x, 
-                                                  int index) const {
-    int dim = base_->empty.n_rows();
-    int start = index * dim;
-    return x.submat(start, 0, start + dim - 1, x.n_cols() - 1);
+ConstArrayView StackedManifold::copy_block(const Array& x, int index) const {
+    int cols = base_->empty.n_cols();
+    return ConstArrayView(x, 0, index * cols, x.n_rows(), cols);
+}
+
+ArrayView StackedManifold::copy_block(Array& x, int index) const {
+    int cols = base_->empty.n_cols();
+    return ArrayView(x, 0, index * cols, x.n_rows(), cols);
 }
 
-ManifoldVector StackedManifold::extract_subvector(const ManifoldVector& v, 
-                                                 int index) const {
-    int dim = base_->empty.n_rows();
-    int start = index * dim;
-    return v.submat(start, 0, start + dim - 1, v.n_cols() - 1);
+void StackedManifold::set_num_threads(int num_threads) {
+    if (num_threads > 1) {
+        pool_ = std::make_shared<ThreadPool>(num_threads);
+        chunk_order_.resize(num_chunks());
+        for (int c = 0; c < num_chunks(); ++c) {
+            chunk_order_[c] = c;
+        }
+    } else {
+        pool_.reset();
+        chunk_order_.clear();
+    }
+}
+
+int StackedManifold::get_num_threads() const {
+    return pool_ ? static_cast<int>(pool_->size()) : 1;
+}
+
+template <typename F>
+void StackedManifold::for_each_chunk(F f) const {
+    const int chunks = num_chunks();
+    auto run_chunk = [&](size_t c) {
+        int first = static_cast<int>(c) * chunk_size;
+        f(first, std::min(chunk_size, num_copies_ - first));
+    };
+    if (pool_ && chunks > 1) {
+        pool_->run(chunk_order_, run_chunk);
+    } else {
+        for (int c = 0; c < chunks; ++c) {
+            run_chunk(c);
+        }
+    }
+}
+
+template <typename F>
+double StackedManifold::sum_chunks(F f) const {
+    const int chunks = num_chunks();
+    double sum = 0.0;
+    if (!pool_ || chunks == 1) {
+        for (int c = 0; c < chunks; ++c) {
+            const int first = c * chunk_size;
+            sum += f(first, std::min(chunk_size, num_copies_ - first));
+        }
+        return sum;
+    }
+
+    std::vector<double> partial(chunks, 0.0);
+    for_each_chunk([&](int first, int count) {
+        partial[first / chunk_size] = f(first, count);
+    });
+    for (double value : partial) {
+        sum += value;
+    }
+    return sum;
 }
 
 double StackedManifold::metric(const ManifoldPoint& x, 
@@ -34,52 +91,30 @@ double StackedManifold::metric(const ManifoldPoint& x,
     check_dimensions(etax, "etax");
     check_dimensions(xix, "xix");
 
-    double sum = 0.0;
-    for (int i = 0; i < num_copies_; ++i) {
-        ManifoldPoint x_i = extract_submanifold(x, i);
-        ManifoldVector etax_i = extract_subvector(etax, i);
-        ManifoldVector xix_i = extract_subvector(xix, i);
-        
-        sum += base_->metric(x_i, etax_i, xix_i);
-    }
-    return sum;
+    return sum_chunks([&](int first, int count) {
+        if (stiefel_base_) {
+            return stiefel_base_->metric_batch(x, etax, xix, first, count);
+        }
+        double sum = 0.0;
+        for (int i = first; i < first + count; ++i) {
+            sum += base_->metric_block(copy_block(x, i), copy_block(etax, i),
+                                       copy_block(xix, i));
+        }
+        return sum;
+    });
 }
 
 ManifoldVector StackedManifold::projection(const ManifoldPoint& x, 
                                          const ManifoldVector& etax) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-
-    ManifoldVector result(x.n_rows(), x.n_cols(), x.is_complex());
-    int dim = base_->empty.n_rows();
-
-    for (int i = 0; i < num_copies_; ++i) {
-        ManifoldPoint x_i = extract_submanifold(x, i);
-        ManifoldVector etax_i = extract_subvector(etax, i);
-        
-        ManifoldVector proj_i = base_->projection(x_i, etax_i);
-        int start = i * dim;
-        result.submat(start, 0, start + dim - 1, result.n_cols() - 1) = proj_i;
-    }
+    ManifoldVector result;
+    projection_into(x, etax, result);
     return result;
 }
 
 ManifoldPoint StackedManifold::retraction(const ManifoldPoint& x, 
                                         const ManifoldVector& etax) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-
-    ManifoldPoint result(x.n_rows(), x.n_cols(), x.is_complex());
-    int dim = base_->empty.n_rows();
-
-    for (int i = 0; i < num_copies_; ++i) {
-        ManifoldPoint x_i = extract_submanifold(x, i);
-        ManifoldVector etax_i = extract_subvector(etax, i);
-        
-        ManifoldPoint retr_i = base_->retraction(x_i, etax_i);
-        int start = i * dim;
-        result.submat(start, 0, start + dim - 1, result.n_cols() - 1) = retr_i;
-    }
+    ManifoldPoint result;
+    retraction_into(x, etax, result);
     return result;
 }
 
@@ -87,25 +122,112 @@ ManifoldVector StackedManifold::vector_transport(const ManifoldPoint& x,
                                                const ManifoldVector& etax,
                                                const ManifoldPoint& y, 
                                                const ManifoldVector& xix) const {
+    ManifoldVector result;
+    vector_transport_into(x, etax, y, xix, result);
+    return result;
+}
+
+void StackedManifold::projection_into(const ManifoldPoint& x, 
+                                      const ManifoldVector& etax,
+                                      ManifoldVector& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+
+    out.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    for_each_chunk([&](int first, int count) {
+        if (stiefel_base_) {
+            stiefel_base_->projection_batch(x, etax, out, first, count);
+            return;
+        }
+        for (int i = first; i < first + count; ++i) {
+            base_->projection_block(copy_block(x, i), copy_block(etax, i), copy_block(out, i));
+        }
+    });
+}
+
+void StackedManifold::retraction_into(const ManifoldPoint& x, 
+                                      const ManifoldVector& etax,
+                                      ManifoldPoint& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+
+    out.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    for_each_chunk([&](int first, int count) {
+        if (stiefel_base_) {
+            stiefel_base_->retraction_batch(x, etax, out, first, count);
+            return;
+        }
+        for (int i = first; i < first + count; ++i) {
+            base_->retraction_block(copy_block(x, i), copy_block(etax, i), copy_block(out, i));
+        }
+    });
+}
+
+void StackedManifold::vector_transport_into(const ManifoldPoint& x, 
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y, 
+                                            const ManifoldVector& xix,
+                                            ManifoldVector& out) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
     check_dimensions(y, "y");
     check_dimensions(xix, "xix");
 
-    ManifoldVector result(x.n_rows(), x.n_cols(), x.is_complex());
-    int dim = base_->empty.n_rows();
-
-    for (int i = 0; i < num_copies_; ++i) {
-        ManifoldPoint x_i = extract_submanifold(x, i);
-        ManifoldVector etax_i = extract_subvector(etax, i);
-        ManifoldPoint y_i = extract_submanifold(y, i);
-        ManifoldVector xix_i = extract_subvector(xix, i);
-        
-        ManifoldVector trans_i = base_->vector_transport(x_i, etax_i, y_i, xix_i);
-        int start = i * dim;
-        result.submat(start, 0, start + dim - 1, result.n_cols() - 1) = trans_i;
+    out.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    for_each_chunk([&](int first, int count) {
+        if (stiefel_base_) {
+            stiefel_base_->vector_transport_batch(x, etax, y, xix, out, first, count);
+            return;
+        }
+        for (int i = first; i < first + count; ++i) {
+            base_->vector_transport_block(copy_block(x, i), copy_block(etax, i),
+                                          copy_block(y, i), copy_block(xix, i),
+                                          copy_block(out, i));
+        }
+    });
+}
+
+double StackedManifold::egrad_to_rgrad(const ManifoldPoint& x, 
+                                      const ManifoldVector& egrad,
+                                      ManifoldVector& rgrad,
+                                      Array* correction) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+
+    rgrad.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    if (correction) {
+        correction->set_size(0, 0, false);
     }
-    return result;
+    return std::sqrt(sum_chunks([&](int first, int count) {
+        double sum = 0.0;
+        for (int i = first; i < first + count; ++i) {
+            const double norm = base_->egrad_to_rgrad_block(copy_block(x, i), copy_block(egrad, i),
+                                                            copy_block(rgrad, i));
+            sum += norm * norm;
+        }
+        return sum;
+    }));
+}
+
+void StackedManifold::ehess_to_rhess(const ManifoldPoint& x, 
+                                     const ManifoldVector& egrad,
+                                     const ManifoldVector& ehess,
+                                     const ManifoldVector& eta,
+                                     ManifoldVector& out,
+                                     const Array*) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(ehess, "ehess");
+    check_dimensions(eta, "eta");
+
+    out.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    for_each_chunk([&](int first, int count) {
+        for (int i = first; i < first + count; ++i) {
+            base_->ehess_to_rhess_block(copy_block(x, i), copy_block(egrad, i),
+                                        copy_block(ehess, i), copy_block(eta, i),
+                                        copy_block(out, i));
+        }
+    });
 }
 
-} // namespace OptimLight
\ No newline at end of file
+} // namespace OptimLight
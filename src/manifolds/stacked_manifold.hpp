@@ -2,24 +2,34 @@
 #define STACKED_MANIFOLD_HPP
 
 #include "manifold.hpp"
+#include "validation.hpp"
 #include "array.hpp"
+#include "stiefel.hpp"
+#include "thread_pool.hpp"
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace OptimLight {
 
+// num_copies copies of a base manifold whose n x p points sit side by side
+// in an n x (p * num_copies) array, copy i in columns [i*p, (i+1)*p). That
+// is the memory layout of an n x p x num_copies cube, so every copy is
+// contiguous. When the base is a Stiefel manifold the operations go through
+// its batched kernels instead of one virtual call per copy.
 class StackedManifold : public Manifold {
 public:
     // Default constructor
-    StackedManifold() : base_(nullptr), num_copies_(0) {
+    StackedManifold() : base_(nullptr), stiefel_base_(nullptr), num_copies_(0) {
         name = "StackedManifold";
         empty = ManifoldVector(0, 0, false); // Initialize empty vector
     }
 
     // Constructor taking base manifold and number of copies
     StackedManifold(const Manifold* base_manifold, int num_copies) 
-        : base_(base_manifold), num_copies_(num_copies) {
+        : base_(base_manifold),
+          stiefel_base_(dynamic_cast<const StiefelBase*>(base_manifold)),
+          num_copies_(num_copies) {
         if (num_copies < 1) {
             throw std::runtime_error("Number of copies must be positive");
         }
@@ -27,16 +37,19 @@ public:
                std::to_string(num_copies) + ")";
         
         // Initialize empty vector with proper dimensions
-        int base_dim = base_manifold->empty.n_rows(); // vertically stacked 
-        empty = ManifoldVector(base_dim * num_copies, 
-                             base_manifold->empty.n_cols(),
+        int base_cols = base_manifold->empty.n_cols(); // stacked side by side
+        empty = ManifoldVector(base_manifold->empty.n_rows(), 
+                             base_cols * num_copies,
                              base_manifold->empty.is_complex());
     }
 
-    // Copy constructor
+    // Copy constructor, copies share the thread pool
     StackedManifold(const StackedManifold& other)
         : base_(other.base_),
-          num_copies_(other.num_copies_) {
+          stiefel_base_(other.stiefel_base_),
+          num_copies_(other.num_copies_),
+          pool_(other.pool_),
+          chunk_order_(other.chunk_order_) {
         name = other.name;
         empty = other.empty;
     }
@@ -45,7 +58,10 @@ public:
     StackedManifold& operator=(const StackedManifold& other) {
         if (this != &other) {
             base_ = other.base_;
+            stiefel_base_ = other.stiefel_base_;
             num_copies_ = other.num_copies_;
+            pool_ = other.pool_;
+            chunk_order_ = other.chunk_order_;
             name = other.name;
             empty = other.empty;
         }
@@ -68,6 +84,34 @@ public:
                                   const ManifoldPoint& y, 
                                   const ManifoldVector& xix) const override;
 
+    void projection_into(const ManifoldPoint& x, 
+                         const ManifoldVector& etax,
+                         ManifoldVector& out) const override;
+
+    void retraction_into(const ManifoldPoint& x, 
+                         const ManifoldVector& etax,
+                         ManifoldPoint& out) const override;
+
+    void vector_transport_into(const ManifoldPoint& x, 
+                               const ManifoldVector& etax,
+                               const ManifoldPoint& y, 
+                               const ManifoldVector& xix,
+                               ManifoldVector& out) const override;
+
+    // Convert copy by copy through the base manifold. The copies keep no
+    // per-point correction, so `correction` is left empty.
+    double egrad_to_rgrad(const ManifoldPoint& x, 
+                          const ManifoldVector& egrad,
+                          ManifoldVector& rgrad,
+                          Array* correction = nullptr) const override;
+
+    void ehess_to_rhess(const ManifoldPoint& x, 
+                        const ManifoldVector& egrad,
+                        const ManifoldVector& ehess,
+                        const ManifoldVector& eta,
+                        ManifoldVector& out,
+                        const Array* correction = nullptr) const override;
+
     int dimension() const  {
         return base_->dimension() * num_copies_;
     }
@@ -79,14 +123,40 @@ public:
     // Getter for number of copies
     int get_num_copies() const { return num_copies_; }
 
+    // Split the copies into fixed-size chunks and run them on a pool of
+    // num_threads threads (the caller included). 1 or less runs them
+    // sequentially on the calling thread. Copies share the pool; an
+    // operation that finds it busy runs inline, see ThreadPool::run, which
+    // also allocates on every call, so a threaded stack is not
+    // allocation-free.
+    void set_num_threads(int num_threads);
+    int get_num_threads() const;
+
 private:
     const Manifold* base_;    // Base manifold to be stacked
+    const StiefelBase* stiefel_base_; // base_ if it is a Stiefel manifold, else null
     int num_copies_;          // Number of copies
+    std::shared_ptr<ThreadPool> pool_; // Null for sequential execution
+    std::vector<size_t> chunk_order_;  // 0, 1, ..., num_chunks() - 1 for the pool
+
+    // Copies per parallel task. Fixed, so that the chunked metric sum does
+    // not depend on the number of threads.
+    static const int chunk_size = 64;
     
     // Helper functions
-    void check_dimensions(const ManifoldPoint& x, const std::string& name) const;
-    ManifoldPoint extract_submanifold(const ManifoldPoint& x, int index) const;
-    ManifoldVector extract_subvector(const ManifoldVector& v, int index) const;
+    void check_dimensions(const ManifoldPoint& x, const char* name) const;
+    // Call f(first, count) for consecutive chunks covering all copies
+    template <typename F>
+    void for_each_chunk(F f) const;
+    int num_chunks() const { return (num_copies_ + chunk_size - 1) / chunk_size; }
+    // Sum of f(first, count) over the chunks, added in chunk order with or
+    // without the pool so that the result does not depend on it
+    template <typename F>
+    double sum_chunks(F f) const;
+
+    // Views of copy `index` inside x
+    ConstArrayView copy_block(const Array& x, int index) const;
+    ArrayView copy_block(Array& x, int index) const;
 };
 
 } // namespace OptimLight
@@ -1,236 +1,857 @@
 #include "stiefel.hpp"
+#include "memory_pool.hpp"
+#include <algorithm>
 #include <cassert>
-#include <armadillo>
+#include <cmath>
 #include <stdexcept>
+#include <string>
 
 namespace OptimLight {
 
-void Stiefel::check_dimensions(const ManifoldPoint& x, const std::string& name) const {
-    if (x.n_rows() != n || x.n_cols() !=p) {
-        throw std::runtime_error(name + " has wrong dimensions. Expected " + 
-                               std::to_string(n) + "x" + std::to_string(p) + 
-                               ", got " + std::to_string(x.n_rows()) + "x" + 
-                               std::to_string(x.n_cols()));
+namespace {
+
+// Kernels of Stiefel<eT>, eT = double or cx_double. TM is either
+// la::Mat<eT>, for the Array storage itself, or la::ConstBlock<eT>, for a
+// block of a product point, so neither path copies its inputs. Their temporaries are PooledMat, drawn from the
+// calling thread's MemoryPool.
+
+// The backend factorisations return false on failure, such as a singular
+// Cayley system or non-finite input, leaving their output unusable
+inline void check_factorisation(bool ok, const char* what) {
+    if (!ok) {
+        throw std::runtime_error(std::string("Stiefel: ") + what + " failed");
     }
 }
 
-void Stiefel::check_orthogonality(const ManifoldPoint& x, const std::string& name, double tol) const {
-    arma::mat I = arma::eye(p, p);
-    if (x.is_complex()) {
-        arma::cx_mat X = x.as_complex();
-        double res = arma::norm(X.t() * X- arma::cx_mat(I, arma::mat(p, p, arma::fill::zeros)), "fro");
-        if ( res > tol) {
-            throw std::runtime_error(name + " is not orthogonal (complex) res =" + std::to_string(res) );
+template <typename TM>
+double orthogonality_residual(const TM& X) {
+    typedef la::elem_t<TM> eT;
+    PooledMat<eT> G(la::cols(X), la::cols(X));
+    la::noalias(G) = la::adjoint(X) * X;
+    la::add_identity(G, eT(-1));
+    return la::norm_fro(G);
+}
+
+template <typename TM>
+double metric_impl(MetricType type, const TM& X, const TM& Z1, const TM& Z2) {
+    typedef la::elem_t<TM> eT;
+    switch (type) {
+        case EUCLIDEAN:
+            return la::inner(Z1, Z2);
+        case CANONICAL: {
+            // <Z1, (I - X X^H / 2) Z2> = <Z1, Z2> - <X^H Z1, X^H Z2> / 2, which
+            // needs only p x p products instead of the n x n Z X^H
+            const la::uword p = la::cols(X);
+            PooledMat<eT> A(p, p), B(p, p);
+            la::noalias(A) = la::adjoint(X) * Z1;
+            la::noalias(B) = la::adjoint(X) * Z2;
+            return la::inner(Z1, Z2) - 0.5 * la::inner(A, B);
         }
-    } else {
-        arma::mat X = x.real();
-        double res = arma::norm( X.t()  * X  - I, "fro")  ;
-        if (res > tol) {
-            throw std::runtime_error(name + " is not orthogonal (real), res = " + std::to_string(res));
+        default:
+            throw std::runtime_error("Unknown metric type");
+    }
+}
+
+// The *_into kernels write into `out`, which may alias the tangent vector
+// argument but not X. Products are accumulated into `out` so that no n x p
+// temporaries are created.
+
+template <typename TM>
+void projection_into_impl(const TM& X, const TM& Z, la::MatRef<la::elem_t<TM>> out) {
+    typedef la::elem_t<TM> eT;
+    const la::uword p = la::cols(X);
+    PooledMat<eT> XZ(p, p), S(p, p);
+    la::noalias(XZ) = la::adjoint(X) * Z;
+    S = 0.5 * (XZ + la::adjoint(XZ));
+    // out = Z - X * symmatu(X^H Z); // this is not correct!
+    if (la::data(out) != la::data(Z)) {
+        out = Z;
+    }
+    la::noalias(out) -= X * S;
+}
+
+// Riemannian gradient of f from its Euclidean gradient G, given
+// M = X^H G. For the Euclidean metric it is the projection G - X sym(M);
+// for the canonical metric it is G - X M^H, whose canonical inner product
+// with any tangent vector equals that of G. Returns its squared norm, taken
+// from `out` itself so that it stays accurate when the gradient is small
+// next to G; for the canonical metric X^H out = M - M^H gives the
+// correction term without another n x p product. `out` may alias G.
+template <typename TM>
+double egrad_to_rgrad_impl(MetricType type, const TM& X, const TM& G,
+                           const PooledMat<la::elem_t<TM>>& M, la::MatRef<la::elem_t<TM>> out) {
+    typedef la::elem_t<TM> eT;
+    const la::uword p = la::cols(X);
+    PooledMat<eT> S(p, p);
+    if (la::data(out) != la::data(G)) {
+        out = G;
+    }
+    switch (type) {
+        case EUCLIDEAN:
+            S = 0.5 * (M + la::adjoint(M));
+            la::noalias(out) -= X * S;
+            return la::inner(out, out);
+        case CANONICAL:
+            S = la::adjoint(M);
+            la::noalias(out) -= X * S;
+            S = M - la::adjoint(M);
+            return la::inner(out, out) - 0.5 * la::inner(S, S);
+        default:
+            throw std::runtime_error("Unknown metric type");
+    }
+}
+
+// Riemannian Hessian of f applied to the tangent vector Xi, from
+// E = D^2 f(X)[Xi], the Euclidean gradient G and M = X^H G. With
+// S = sym(M), it is the projection of E - Xi S for the Euclidean metric
+// (Absil, Mahony and Trumpf), and for the canonical metric
+//     A = E + (X Xi^H G + G Xi^H X) / 2 - (I - X X^H) Xi S,
+// the Hessian form of Edelman, Arias and Smith, mapped to the tangent
+// vector A - X A^H X as in egrad_to_rgrad_impl. All the corrections are
+// n x p times p x p products. `out` may alias E.
+template <typename TM>
+void ehess_to_rhess_impl(MetricType type, const TM& X, const TM& G, const TM& E, const TM& Xi,
+                         const PooledMat<la::elem_t<TM>>& M, la::MatRef<la::elem_t<TM>> out) {
+    typedef la::elem_t<TM> eT;
+    const la::uword p = la::cols(X);
+    PooledMat<eT> S(p, p), B(p, p), C(p, p);
+    S = 0.5 * (M + la::adjoint(M));
+    if (la::data(out) != la::data(E)) {
+        out = E;
+    }
+    la::noalias(out) -= Xi * S;
+    switch (type) {
+        case EUCLIDEAN:
+            la::noalias(B) = la::adjoint(X) * out;
+            C = 0.5 * (B + la::adjoint(B));
+            la::noalias(out) -= X * C;
+            return;
+        case CANONICAL:
+            // A = out + (G Xi^H X + X (Xi^H G + 2 X^H Xi S)) / 2
+            la::noalias(C) = la::adjoint(Xi) * X;
+            la::noalias(out) += 0.5 * G * C;
+            la::noalias(B) = la::adjoint(Xi) * G;
+            la::noalias(B) += 2.0 * la::adjoint(C) * S;
+            la::noalias(out) += 0.5 * X * B;
+            la::noalias(B) = la::adjoint(X) * out;
+            C = la::adjoint(B);
+            la::noalias(out) -= X * C;
+            return;
+        default:
+            throw std::runtime_error("Unknown metric type");
+    }
+}
+
+// S = G^{-1/2} for a Hermitian positive definite p x p G, from its
+// eigendecomposition
+template <typename eT>
+void inverse_sqrt_eig(const PooledMat<eT>& G, la::MatRef<eT> S) {
+    const la::uword p = la::rows(G);
+    PooledMat<eT> V(p, p), VD(p, p);
+    la::vec d;
+    check_factorisation(la::eig_sym(d, V, G), "eigendecomposition");
+    for (la::uword j = 0; j < p; ++j) {
+        VD.col(j) = V.col(j) / std::sqrt(d(j));
+    }
+    la::noalias(S) = VD * la::adjoint(V);
+}
+
+// S = G^{-1/2} by the coupled Newton-Schulz iteration on G / c, where c
+// bounds the largest eigenvalue so the iteration converges. It costs only
+// p x p products and converges in a few steps when G is close to I, as it
+// is for short retraction steps. Returns false if it did not converge.
+template <typename eT>
+bool inverse_sqrt_newton_schulz(const PooledMat<eT>& G, la::MatRef<eT> S) {
+    const la::uword p = la::rows(G);
+    const int max_iterations = 20;
+    const double tol = 1e-14 * std::sqrt(static_cast<double>(p));
+    const double c = la::norm_inf(G);
+
+    PooledMat<eT> Y(p, p), T(p, p), W(p, p);
+    const la::MapMat<eT>& product = W;
+    Y = G / c;
+    la::set_identity(S);
+    for (int k = 0; k < max_iterations; ++k) {
+        la::noalias(T) = S * Y;
+        T *= eT(-0.5);
+        la::add_identity(T, eT(1.5));
+        la::noalias(W) = Y * T;
+        Y = product;
+        la::noalias(W) = T * S;
+        S = product;
+        la::add_identity(T, eT(-1));
+        if (la::norm_fro(T) < tol) {
+            S /= std::sqrt(c);
+            return true;
         }
     }
+    return false;
+}
+
+// Cayley transform out = (I - W/2)^{-1} (I + W/2) B for the n x n skew matrix
+// W = P Z X^H - X Z^H P, P = I - X X^H / 2, which satisfies W X = Z for a
+// tangent Z. W = U V^H with U = [PZ, X] and V = [X, -PZ] has rank 2p, and
+// (I - W/2)^{-1} U = U (I - V^H U / 2)^{-1}, so
+//     out = B + U (I - V^H U / 2)^{-1} V^H B
+// needs one 2p x 2p solve and O(n p^2) work; W itself is never formed.
+// `out` may alias B, which may have any number of columns.
+template <typename TM, typename TB>
+void cayley_solve(const TM& X, const TM& Z, const TB& B, la::MatRef<la::elem_t<TM>> out) {
+    typedef la::elem_t<TM> eT;
+    const la::uword n = la::rows(X);
+    const la::uword p = la::cols(X);
+    const la::uword q = la::cols(B);
+
+    PooledMat<eT> XZ(p, p), PZ(n, p);
+    la::noalias(XZ) = la::adjoint(X) * Z;
+    PZ = Z;
+    la::noalias(PZ) -= 0.5 * X * XZ;
+
+    // M = I - V^H U / 2, assembled block by block
+    PooledMat<eT> M(2*p, 2*p), G(p, p);
+    la::noalias(G) = la::adjoint(X) * PZ;
+    la::block(M, 0, 0, p, p) = -0.5 * G;
+    la::noalias(G) = la::adjoint(X) * X;
+    la::block(M, 0, p, p, p) = -0.5 * G;
+    la::noalias(G) = la::adjoint(PZ) * PZ;
+    la::block(M, p, 0, p, p) = 0.5 * G;
+    la::noalias(G) = la::adjoint(PZ) * X;
+    la::block(M, p, p, p, p) = 0.5 * G;
+    la::add_identity(M, eT(1));
+
+    // V^H B
+    PooledMat<eT> VB(2*p, q), C(2*p, q), H(p, q);
+    la::noalias(H) = la::adjoint(X) * B;
+    la::block(VB, 0, 0, p, q) = H;
+    la::noalias(H) = la::adjoint(PZ) * B;
+    la::block(VB, p, 0, p, q) = -H;
+    check_factorisation(la::solve(C, M, VB), "Cayley solve");
+
+    if (la::data(B) != la::data(out)) {
+        out = B;
+    }
+    H = la::block(C, 0, 0, p, q);
+    la::noalias(out) += PZ * H;
+    H = la::block(C, p, 0, p, q);
+    la::noalias(out) += X * H;
 }
 
-void Stiefel::symmatu(arma::mat& result, const arma::mat& X) const {
-    result = (X + X.t()) / 2.0;
-    result = arma::trimatu(result);
+// Factors of the geodesic of the canonical metric (Edelman, Arias and
+// Smith),
+//     R_X(t Z) = [X, Q] exp(t M) [I; 0],   M = [W, -R^H; R, 0],
+// with W = X^H Z and the thin QR factorisation Q R = Z - X W.
+template <typename TM>
+void exp_factors(const TM& X, const TM& Z, la::MatRef<la::elem_t<TM>> Q,
+                 la::MatRef<la::elem_t<TM>> M) {
+    typedef la::elem_t<TM> eT;
+    const la::uword n = la::rows(X);
+    const la::uword p = la::cols(X);
+
+    PooledMat<eT> W(p, p), A(n, p), R(p, p);
+    la::noalias(W) = la::adjoint(X) * Z;
+    A = Z;
+    la::noalias(A) -= X * W;
+    check_factorisation(la::qr_econ(Q, R, A), "QR factorisation");
+
+    la::block(M, 0, 0, p, p) = W;
+    la::block(M, 0, p, p, p) = -la::adjoint(R);
+    la::block(M, p, 0, p, p) = R;
+    la::set_zero(la::block(M, p, p, p, p));
 }
 
-double Stiefel::metric(const ManifoldPoint& x, 
-                      const ManifoldVector& etax, 
-                      const ManifoldVector& xix) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-    check_dimensions(xix, "xix");
+template <typename TM>
+void retraction_into_impl(RetractionType type, const TM& X, const TM& Z,
+                          la::MatRef<la::elem_t<TM>> out) {
+    typedef la::elem_t<TM> eT;
+    const la::uword n = la::rows(X);
+    const la::uword p = la::cols(X);
 
-    if (x.is_complex() || etax.is_complex() || xix.is_complex()) {
-        arma::cx_mat X = x.as_complex();
-        arma::cx_mat Z1 = etax.as_complex();
-        arma::cx_mat Z2 = xix.as_complex();
-
-        switch (metric_type_) {
-            case EUCLIDEAN:
-                return std::real(arma::accu(arma::conj(Z1) % Z2));
-            case CANONICAL:
-                return std::real(arma::accu(arma::conj(Z1) % Z2) - 
-                       0.5 * arma::accu(arma::conj(Z1 * X.t()) % (Z2 * X.t())));
-            default:
-                throw std::runtime_error("Unknown metric type");
+    switch (type) {
+        case RT_QF: {
+            PooledMat<eT> R(p, p);
+            check_factorisation(la::qr_econ(out, R, X + Z), "QR factorisation");
+            // Fix the column phases so that R has a positive real diagonal,
+            // which makes qf(X + Z) unique
+            for (la::uword j = 0; j < p; ++j) {
+                const double r = std::abs(R(j, j));
+                if (r > 0.0) {
+                    out.col(j) *= R(j, j) / r;
+                }
+            }
+            return;
         }
-    } else {
-        arma::mat X = x.real();
-        arma::mat Z1 = etax.real();
-        arma::mat Z2 = xix.real();
-
-        switch (metric_type_) {
-            case EUCLIDEAN:
-                return arma::accu(Z1 % Z2);
-            case CANONICAL:
-                return arma::accu(Z1 % Z2) - 0.5 * arma::accu((Z1 * X.t()) % (Z2 * X.t()));
-            default:
-                throw std::runtime_error("Unknown metric type");
+        case RT_POLAR:
+        case RT_POLAR_NS: {
+            // The polar factor of Y = X + Z is Y G^{-1/2} with the p x p
+            // Gram matrix G = Y^H Y = I + Z^H Z + X^H Z + Z^H X, so only a
+            // p x p factorisation is needed besides one n x p product
+            PooledMat<eT> G(p, p), S(p, p), Y(n, p);
+            la::noalias(G) = la::adjoint(X) * Z;
+            la::noalias(S) = la::adjoint(Z) * Z;
+            S += G + la::adjoint(G);
+            la::add_identity(S, eT(1));
+            G = 0.5 * (S + la::adjoint(S));
+            if (type == RT_POLAR || !inverse_sqrt_newton_schulz(G, S)) {
+                inverse_sqrt_eig(G, S);
+            }
+            Y = X + Z;
+            la::noalias(out) = Y * S;
+            return;
+        }
+        case RT_CAYLEY: {
+            cayley_solve(X, Z, X, out);
+            return;
+        }
+        case RT_EXP: {
+            PooledMat<eT> Q(n, p), M(2*p, 2*p), E(2*p, 2*p);
+            exp_factors(X, Z, Q, M);
+            check_factorisation(la::expmat(E, M), "matrix exponential");
+            la::noalias(out) = X * la::block(E, 0, 0, p, p);
+            la::noalias(out) += Q * la::block(E, p, 0, p, p);
+            return;
         }
+        default:
+            throw std::runtime_error("Unsupported retraction type");
     }
 }
 
-ManifoldVector Stiefel::projection(const ManifoldPoint& x, 
-                                 const ManifoldVector& etax) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-    check_orthogonality(x, "x");
+template <typename TM>
+void cayley_transport_into_impl(const TM& X, const TM& Z, const TM& Xi,
+                                la::MatRef<la::elem_t<TM>> out) {
+    cayley_solve(X, Z, Xi, out);
+}
 
-    if (is_complex_) {
-        arma::cx_mat X = x.as_complex();
-        arma::cx_mat Z= etax.as_complex();
-        arma::cx_mat XZ = X.t() * Z;
-        // arma::cx_mat P = Z-   X * arma::symmatu(X.t() * Z); // this is not correct!
-        arma::cx_mat P = Z - 0.5* X * ( XZ + XZ.t() );
-        return ManifoldVector(P);
-    } else {
-        arma::mat X = x.as_mat();
-        arma::mat Z= etax.as_mat();
-        arma::mat XZ = X.t() * Z;
-        // arma::mat P = Z- X * arma::symmatu(X.t() * Z); // this is not correct!
-        arma::mat P = Z - 0.5* X * ( XZ + XZ.t() );
-        return ManifoldVector(P);
+// Transport of m tangent vectors packed side by side in P (n x mp) from
+// T_X to T_Y along Z, in place. Both transports handle all the vectors in
+// one pass: the projection with two n x mp products, the Cayley transport
+// with one 2p x 2p solve for all the right-hand sides.
+template <typename TM, typename TY>
+void transport_packed_impl(VectorTransportType type, const TM& X, const TM& Z, const TY& Y,
+                           la::MatRef<la::elem_t<TM>> P) {
+    typedef la::elem_t<TM> eT;
+    const la::uword p = la::cols(X);
+    const la::uword m = la::cols(P) / p;
+
+    switch (type) {
+        case VT_PROJECTION:
+        case VT_PARALLELTRANSLATION: {
+            // P_j -= Y sym(Y^H P_j) for every block j
+            PooledMat<eT> B(p, m * p), S(p, p);
+            la::noalias(B) = la::adjoint(Y) * P;
+            for (la::uword j = 0; j < m; ++j) {
+                S = la::block(B, 0, j * p, p, p);
+                la::block(B, 0, j * p, p, p) = 0.5 * (S + la::adjoint(S));
+            }
+            la::noalias(P) -= Y * B;
+            return;
+        }
+        case VT_CAYLEY:
+            cayley_solve(X, Z, P, P);
+            return;
+        default:
+            throw std::runtime_error("Unsupported vector transport type");
     }
 }
 
-ManifoldPoint Stiefel::retraction(const ManifoldPoint& x, 
-                                const ManifoldVector& etax) const {
-    check_dimensions(x, "x");
-    check_dimensions(etax, "etax");
-    check_orthogonality(x, "x");
+// Copy the n x p vectors into P side by side from column block `first` on,
+// and back
+template <typename eT>
+void pack(const std::vector<ArrayView>& xis, la::uword first, la::MatRef<eT> P) {
+    const la::uword n = la::rows(P);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        const la::uword p = xis[i].n_cols();
+        la::block(P, 0, (first + i) * p, n, p) = xis[i].as<eT>();
+    }
+}
+
+template <typename eT>
+void unpack(const PooledMat<eT>& P, la::uword first, const std::vector<ArrayView>& xis) {
+    const la::uword n = la::rows(P);
+    for (size_t i = 0; i < xis.size(); ++i) {
+        const la::uword p = xis[i].n_cols();
+        xis[i].as<eT>() = la::block(P, 0, (first + i) * p, n, p);
+    }
+}
+
+// Retraction curve t -> R_X(t Z) on Stiefel<eT>. What does not depend on t
+// is computed once per X and Z, when the curve is made or reset:
+//   RT_EXP     Q and M of exp_factors, so each t costs the 2p x 2p
+//              exponential of t M and two n x p products
+//   RT_CAYLEY  PZ = (I - X X^H / 2) Z and the p x p blocks of V^H U and
+//              V^H X in cayley_solve, which for the step t Z scale with 1,
+//              t or t^2, so each t costs one 2p x 2p solve
+//   RT_POLAR*  X^H Z + Z^H X and Z^H Z, the parts of the Gram matrix
+//              G(t) = I + t (X^H Z + Z^H X) + t^2 Z^H Z
+// RT_QF has nothing to share and retracts t Z afresh.
+template <typename eT>
+class StiefelCurve : public RetractionCurve {
+public:
+    StiefelCurve(const Stiefel<eT>& manifold, const la::Mat<eT>& X, const la::Mat<eT>& Z)
+        : manifold_(manifold) {
+        bind(X, Z);
+    }
 
-    if (is_complex_) {
-        arma::cx_mat X = x.as_complex();
-        arma::cx_mat Z= etax.as_complex();
+    bool reset(const Manifold& manifold, const ManifoldPoint& x,
+               const ManifoldVector& etax) override {
+        if (&manifold != &manifold_) {
+            return false;
+        }
+        bind(x.as<eT>(), etax.as<eT>());
+        return true;
+    }
 
-        switch (retraction_type_) {
-            case RT_QF: {
-                arma::cx_mat Q, R;
-                arma::qr_econ(Q, R, X + Z);
-                return ManifoldPoint(Q);  // Added complex flag
+    void evaluate(double t, ManifoldPoint& out) const override {
+        out.set_size<eT>(la::rows(X_), la::cols(X_));
+        evaluate_into(t, out.as<eT>());
+    }
+
+    void evaluate_block(double t, const ArrayView& out) const override {
+        PooledMat<eT> result(la::rows(X_), la::cols(X_));
+        evaluate_into(t, result);
+        out.as<eT>() = result;
+    }
+
+private:
+    const Stiefel<eT>& manifold_;
+    RetractionType type_;
+    la::Mat<eT> X_;
+    la::Mat<eT> D_;   // Q for RT_EXP, PZ for RT_CAYLEY, otherwise Z
+    la::Mat<eT> M_;   // The p x p or 2p x 2p factors of the type
+    mutable la::Mat<eT> step_; // t Z for RT_QF
+
+    // The t-independent parts for X and Z, reusing the members' storage
+    void bind(const la::Mat<eT>& X, const la::Mat<eT>& Z) {
+        type_ = manifold_.get_retraction_type();
+        X_ = X;
+        const la::uword n = la::rows(X);
+        const la::uword p = la::cols(X);
+        switch (type_) {
+            case RT_EXP:
+                la::resize(D_, n, p);
+                la::resize(M_, 2*p, 2*p);
+                exp_factors(X, Z, D_, M_);
+                return;
+            case RT_CAYLEY: {
+                PooledMat<eT> G(p, p);
+                la::noalias(G) = la::adjoint(X) * Z;
+                D_ = Z;
+                la::noalias(D_) -= 0.5 * X * G;
+                la::resize(M_, 2*p, 2*p);
+                la::noalias(G) = la::adjoint(X) * D_;
+                la::block(M_, 0, 0, p, p) = G;
+                la::noalias(G) = la::adjoint(X) * X;
+                la::block(M_, 0, p, p, p) = G;
+                la::noalias(G) = la::adjoint(D_) * D_;
+                la::block(M_, p, 0, p, p) = G;
+                la::noalias(G) = la::adjoint(D_) * X;
+                la::block(M_, p, p, p, p) = G;
+                return;
+            }
+            case RT_POLAR:
+            case RT_POLAR_NS: {
+                D_ = Z;
+                PooledMat<eT> G(p, p);
+                la::resize(M_, p, 2*p);
+                la::noalias(G) = la::adjoint(X) * Z;
+                la::block(M_, 0, 0, p, p) = G + la::adjoint(G);
+                la::noalias(G) = la::adjoint(Z) * Z;
+                la::block(M_, 0, p, p, p) = G;
+                return;
             }
-            case RT_POLAR: {
-                arma::cx_mat U, V;
-                arma::vec s;
-                arma::svd_econ(U, s, V, X + Z);
-                arma::cx_mat result = U * V.t();
-                // result.brief_print("result");
-                return ManifoldPoint(result);
+            default:
+                D_ = Z;
+                return;
+        }
+    }
+
+    void evaluate_into(double t, la::MatRef<eT> out) const {
+        const la::uword n = la::rows(X_);
+        const la::uword p = la::cols(X_);
+        switch (type_) {
+            case RT_EXP: {
+                PooledMat<eT> tM(2*p, 2*p), E(2*p, 2*p);
+                tM = eT(t) * M_;
+                check_factorisation(la::expmat(E, tM), "matrix exponential");
+                la::noalias(out) = X_ * la::block(E, 0, 0, p, p);
+                la::noalias(out) += D_ * la::block(E, p, 0, p, p);
+                return;
             }
             case RT_CAYLEY: {
-                arma::cx_mat W = Z* X.t() - X * Z.t();
-                arma::cx_mat I = arma::eye<arma::cx_mat>(n, n);  // Changed p to n
-                arma::cx_mat cayley = arma::solve(I + W/2.0, I - W/2.0) * X;
-                return ManifoldPoint(cayley);  // Added complex flag
+                // I - V^H U / 2 and V^H X for U = [t PZ, X], V = [X, -t PZ]
+                PooledMat<eT> A(2*p, 2*p), VX(2*p, p), C(2*p, p), H(p, p);
+                la::block(A, 0, 0, p, p) = eT(-0.5 * t) * la::block(M_, 0, 0, p, p);
+                la::block(A, 0, p, p, p) = eT(-0.5) * la::block(M_, 0, p, p, p);
+                la::block(A, p, 0, p, p) = eT(0.5 * t * t) * la::block(M_, p, 0, p, p);
+                la::block(A, p, p, p, p) = eT(0.5 * t) * la::block(M_, p, p, p, p);
+                la::add_identity(A, eT(1));
+                la::block(VX, 0, 0, p, p) = la::block(M_, 0, p, p, p);
+                la::block(VX, p, 0, p, p) = eT(-t) * la::block(M_, p, p, p, p);
+                check_factorisation(la::solve(C, A, VX), "Cayley solve");
+
+                out = X_;
+                H = eT(t) * la::block(C, 0, 0, p, p);
+                la::noalias(out) += D_ * H;
+                H = la::block(C, p, 0, p, p);
+                la::noalias(out) += X_ * H;
+                return;
             }
-            case RT_EXP: {
-                // Get matrices as Armadillo complex objects
-                arma::cx_mat X = x.as_complex();
-                arma::cx_mat Z = etax.as_complex();
-                
-                // Step 1: Compute W = X^H Z
-                arma::cx_mat W = X.t() * Z;
-                
-                // Step 2: Compute A = Z - X*W
-                arma::cx_mat A = Z - X * W;
-                
-                // Step 3: Compute QR decomposition of A
-                arma::cx_mat Q, R;
-                arma::qr_econ(Q, R, A);
-                
-                // Step 4: Form the block matrix M
-                arma::cx_mat M = arma::zeros<arma::cx_mat>(2*p, 2*p);
-                M.submat(0, 0, p-1, p-1) = W;
-                M.submat(0, p, p-1, 2*p-1) = -R.t() * R;
-                M.submat(p, 0, 2*p-1, p-1) = arma::eye<arma::cx_mat>(p, p);
-                
-                // Step 5: Compute matrix exponential of M
-                arma::cx_mat expM = arma::expmat(M);
-                
-                // Step 6: Extract the top blocks
-                arma::cx_mat expM11 = expM.submat(0, 0, p-1, p-1);
-                arma::cx_mat expM21 = expM.submat(p, 0, 2*p-1, p-1);
-                
-                // Step 7: Compute final result Y = X*expM11 + Q*expM21
-                arma::cx_mat Y = X * expM11 + Q * expM21;
-                
-                return ManifoldPoint(Y);
+            case RT_POLAR:
+            case RT_POLAR_NS: {
+                PooledMat<eT> G(p, p), S(p, p), Y(n, p);
+                S = eT(t) * la::block(M_, 0, 0, p, p) + eT(t * t) * la::block(M_, 0, p, p, p);
+                la::add_identity(S, eT(1));
+                G = 0.5 * (S + la::adjoint(S));
+                if (type_ == RT_POLAR || !inverse_sqrt_newton_schulz(G, S)) {
+                    inverse_sqrt_eig(G, S);
+                }
+                Y = X_ + eT(t) * D_;
+                la::noalias(out) = Y * S;
+                return;
             }
             default:
-                throw std::runtime_error("Unsupported retraction type");
+                step_ = eT(t) * D_;
+                retraction_into_impl(type_, X_, step_, out);
+                return;
         }
-    } else {
-        arma::mat X = x.as_mat();
-        arma::mat Z= etax.as_mat();
-
-        switch (retraction_type_) {
-            case RT_QF: {
-                arma::mat Q, R;
-                arma::qr_econ(Q, R, X + Z);
-                return ManifoldPoint(Q);
-            }
-            case RT_POLAR: {
-                arma::mat U, V;
-                arma::vec s;
-                arma::svd_econ(U, s, V, X + Z);
-                arma::mat result = U * V.t();
+    }
+};
+
+// Views of the vectors xis, in a vector kept per thread so that the
+// batched transports do not allocate once it has grown. Valid until the
+// next call on the same thread.
+const std::vector<ArrayView>& views_of(const std::vector<ManifoldVector*>& xis) {
+    thread_local std::vector<ArrayView> views;
+    views.clear();
+    for (ManifoldVector* xi : xis) {
+        views.emplace_back(*xi);
+    }
+    return views;
+}
+
+// Kernels for the batched path with small n. They work on raw column-major
+// n x p slices and skip the per-call overhead of BLAS/LAPACK, which
+// dominates at these sizes; the loops over rows are contiguous and left to
+// the compiler to vectorise.
 
-                // result.brief_print("result");
+inline double conj_elem(double v) { return v; }
+inline la::cx_double conj_elem(const la::cx_double& v) { return std::conj(v); }
 
-                return ManifoldPoint(result, false);
+const la::uword small_batch_rows = 16;
+
+// P = Z - X sym(X^H Z). P may alias Z.
+template <typename eT>
+void projection_small(const eT* X, const eT* Z, eT* P, la::uword n, la::uword p) {
+    eT S[small_batch_rows * small_batch_rows];
+    for (la::uword b = 0; b < p; ++b) {
+        for (la::uword a = 0; a < p; ++a) {
+            eT acc = eT(0);
+            for (la::uword r = 0; r < n; ++r) {
+                acc += conj_elem(X[r + a * n]) * Z[r + b * n];
             }
-            case RT_CAYLEY: {
-                arma::mat W = Z* X.t() - X * Z.t();
-                arma::mat I = arma::eye(p, p);
-                arma::mat cayley = arma::solve(I + W/2.0, I - W/2.0) * X;
-                return ManifoldPoint(cayley);
+            S[a + b * p] = acc;
+        }
+    }
+    for (la::uword b = 0; b < p; ++b) {
+        for (la::uword a = 0; a <= b; ++a) {
+            eT sym = 0.5 * (S[a + b * p] + conj_elem(S[b + a * p]));
+            S[a + b * p] = sym;
+            S[b + a * p] = conj_elem(sym);
+        }
+    }
+    for (la::uword b = 0; b < p; ++b) {
+        for (la::uword r = 0; r < n; ++r) {
+            eT acc = Z[r + b * n];
+            for (la::uword a = 0; a < p; ++a) {
+                acc -= X[r + a * n] * S[a + b * p];
             }
-            case RT_EXP: {
-                // Get matrices as Armadillo objects
-                arma::mat X = x.as_mat();
-                arma::mat Z = etax.as_mat();
-                
-                // Step 1: Compute W = X^T Z (p × p matrix)
-                arma::mat W = X.t() * Z;
-                
-                // Step 2: Compute A = Z - X*W (n × p matrix)
-                arma::mat A = Z - X * W;
-                
-                // Step 3: Compute QR decomposition of A
-                arma::mat Q, R;
-                arma::qr_econ(Q, R, A);
-                
-                // Step 4: Form the block matrix M
-                arma::mat M = arma::zeros(2*p, 2*p);
-                M.submat(0, 0, p-1, p-1) = W;
-                M.submat(0, p, p-1, 2*p-1) = -R.t() * R;
-                M.submat(p, 0, 2*p-1, p-1) = arma::eye(p, p);
-                
-                // Step 5: Compute matrix exponential of M
-                arma::mat expM = arma::expmat(M);
-                
-                // Step 6: Extract the top blocks
-                arma::mat expM11 = expM.submat(0, 0, p-1, p-1);
-                arma::mat expM21 = expM.submat(p, 0, 2*p-1, p-1);
-                
-                // Step 7: Compute final result Y = X*expM11 + Q*expM21
-                arma::mat Y = X * expM11 + Q * expM21;
-                
-                return ManifoldPoint(Y);
+            P[r + b * n] = acc;
+        }
+    }
+}
+
+// Y = qf(X + Z) by modified Gram-Schmidt with one reorthogonalisation pass,
+// giving the R factor a positive real diagonal. Y may alias Z.
+template <typename eT>
+void qf_retraction_small(const eT* X, const eT* Z, eT* Y, la::uword n, la::uword p) {
+    for (la::uword i = 0; i < n * p; ++i) {
+        Y[i] = X[i] + Z[i];
+    }
+    for (la::uword j = 0; j < p; ++j) {
+        eT* yj = Y + j * n;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (la::uword i = 0; i < j; ++i) {
+                const eT* yi = Y + i * n;
+                eT r = eT(0);
+                for (la::uword k = 0; k < n; ++k) {
+                    r += conj_elem(yi[k]) * yj[k];
+                }
+                for (la::uword k = 0; k < n; ++k) {
+                    yj[k] -= r * yi[k];
+                }
             }
-            default:
-                throw std::runtime_error("Unsupported retraction type");
         }
+        double norm2 = 0.0;
+        for (la::uword k = 0; k < n; ++k) {
+            norm2 += std::norm(yj[k]);
+        }
+        const double scale = 1.0 / std::sqrt(norm2);
+        for (la::uword k = 0; k < n; ++k) {
+            yj[k] *= scale;
+        }
+    }
+}
+
+// Column-major n x p slice `index` of a batched array, aliased without copying
+template <typename eT>
+la::MapMat<eT> slice_alias(const la::Mat<eT>& A, la::uword n, la::uword p, int index) {
+    return la::MapMat<eT>(const_cast<eT*>(la::data(A)) + static_cast<la::uword>(index) * n * p,
+                          n, p);
+}
+
+template <typename eT>
+double metric_batch_impl(MetricType type, const la::Mat<eT>& X, const la::Mat<eT>& Z1,
+                         const la::Mat<eT>& Z2, la::uword n, la::uword p,
+                         int first, int count) {
+    if (type == EUCLIDEAN) {
+        // One fused pass over all the copies of the range
+        const la::uword offset = static_cast<la::uword>(first) * n * p;
+        const la::uword len = static_cast<la::uword>(count) * n * p;
+        const la::MapMat<eT> a(const_cast<eT*>(la::data(Z1)) + offset, len, 1);
+        const la::MapMat<eT> b(const_cast<eT*>(la::data(Z2)) + offset, len, 1);
+        return la::inner(a, b);
+    }
+    double sum = 0.0;
+    for (int i = first; i < first + count; ++i) {
+        sum += metric_impl(type, slice_alias(X, n, p, i), slice_alias(Z1, n, p, i),
+                           slice_alias(Z2, n, p, i));
+    }
+    return sum;
+}
+
+template <typename eT>
+void projection_batch_impl(const la::Mat<eT>& X, const la::Mat<eT>& Z, la::Mat<eT>& out,
+                           la::uword n, la::uword p, int first, int count) {
+    for (int i = first; i < first + count; ++i) {
+        const la::uword offset = static_cast<la::uword>(i) * n * p;
+        if (n <= small_batch_rows) {
+            projection_small(la::data(X) + offset, la::data(Z) + offset,
+                             la::data(out) + offset, n, p);
+        } else if (&out == &Z) {
+            la::MapMat<eT> Zi = slice_alias(Z, n, p, i);
+            projection_into_impl(slice_alias(X, n, p, i), Zi, Zi);
+        } else {
+            la::MapMat<eT> Oi = slice_alias(out, n, p, i);
+            projection_into_impl(slice_alias(X, n, p, i), slice_alias(Z, n, p, i), Oi);
+        }
+    }
+}
+
+template <typename eT>
+void retraction_batch_impl(RetractionType type, const la::Mat<eT>& X, const la::Mat<eT>& Z,
+                           la::Mat<eT>& out, la::uword n, la::uword p,
+                           int first, int count) {
+    for (int i = first; i < first + count; ++i) {
+        const la::uword offset = static_cast<la::uword>(i) * n * p;
+        if (type == RT_QF && n <= small_batch_rows) {
+            qf_retraction_small(la::data(X) + offset, la::data(Z) + offset,
+                                la::data(out) + offset, n, p);
+        } else {
+            la::MapMat<eT> Oi = slice_alias(out, n, p, i);
+            retraction_into_impl(type, slice_alias(X, n, p, i), slice_alias(Z, n, p, i), Oi);
+        }
+    }
+}
+
+template <typename eT>
+void cayley_transport_batch_impl(const la::Mat<eT>& X, const la::Mat<eT>& Z,
+                                 const la::Mat<eT>& Xi, la::Mat<eT>& out,
+                                 la::uword n, la::uword p, int first, int count) {
+    for (int i = first; i < first + count; ++i) {
+        la::MapMat<eT> Oi = slice_alias(out, n, p, i);
+        cayley_transport_into_impl(slice_alias(X, n, p, i), slice_alias(Z, n, p, i),
+                                   slice_alias(Xi, n, p, i), Oi);
+    }
+}
+
+} // namespace
+
+void StiefelBase::check_dimensions(const ConstArrayView& x, const char* name) const {
+    if (!validation::dimensions_enabled) return;
+    if (x.n_rows() != n || x.n_cols() !=p) {
+        throw std::runtime_error(std::string(name) + " has wrong dimensions. Expected " + 
+                               std::to_string(n) + "x" + std::to_string(p) + 
+                               ", got " + std::to_string(x.n_rows()) + "x" + 
+                               std::to_string(x.n_cols()));
     }
 }
 
-ManifoldVector Stiefel::vector_transport(const ManifoldPoint& x, 
+template <typename T>
+void Stiefel<T>::check_orthogonality(const ConstArrayView& x, const char* name, double tol) const {
+    if (!validation::sample_expensive()) return;
+    double res = orthogonality_residual(x.as<T>());
+    if (res > tol) {
+        throw std::runtime_error(std::string(name) + " is not orthogonal, res = " + std::to_string(res));
+    }
+}
+
+template <typename T>
+double Stiefel<T>::metric(const ManifoldPoint& x, 
+                          const ManifoldVector& etax, 
+                          const ManifoldVector& xix) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(xix, "xix");
+
+    return metric_impl(metric_type_, x.as<T>(), etax.as<T>(), xix.as<T>());
+}
+
+template <typename T>
+ManifoldVector Stiefel<T>::projection(const ManifoldPoint& x, 
+                                      const ManifoldVector& etax) const {
+    ManifoldVector result;
+    projection_into(x, etax, result);
+    return result;
+}
+
+template <typename T>
+ManifoldPoint Stiefel<T>::retraction(const ManifoldPoint& x, 
+                                     const ManifoldVector& etax) const {
+    ManifoldPoint result;
+    retraction_into(x, etax, result);
+    return result;
+}
+
+template <typename T>
+ManifoldVector Stiefel<T>::vector_transport(const ManifoldPoint& x, 
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y, 
+                                            const ManifoldVector& xix) const {
+    ManifoldVector result;
+    vector_transport_into(x, etax, y, xix, result);
+    return result;
+}
+
+template <typename T>
+void Stiefel<T>::projection_into(const ManifoldPoint& x, 
+                                 const ManifoldVector& etax,
+                                 ManifoldVector& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_orthogonality(x, "x");
+
+    out.set_size<T>(n, p);
+    projection_into_impl(x.as<T>(), etax.as<T>(), out.as<T>());
+}
+
+template <typename T>
+void Stiefel<T>::retraction_into(const ManifoldPoint& x, 
+                                 const ManifoldVector& etax,
+                                 ManifoldPoint& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_orthogonality(x, "x");
+
+    out.set_size<T>(n, p);
+    retraction_into_impl(retraction_type_, x.as<T>(), etax.as<T>(), out.as<T>());
+}
+
+template <typename T>
+void Stiefel<T>::vector_transport_into(const ManifoldPoint& x, 
                                        const ManifoldVector& etax,
                                        const ManifoldPoint& y, 
-                                       const ManifoldVector& xix) const {
+                                       const ManifoldVector& xix,
+                                       ManifoldVector& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(y, "y");
+    check_dimensions(xix, "xix");
+    check_orthogonality(x, "x");
+    check_orthogonality(y, "y");
+
+    switch (vector_transport_type_) {
+        case VT_PROJECTION:
+        case VT_PARALLELTRANSLATION:
+            projection_into(y, xix, out);
+            return;
+        case VT_CAYLEY:
+            out.set_size<T>(n, p);
+            cayley_transport_into_impl(x.as<T>(), etax.as<T>(), xix.as<T>(), out.as<T>());
+            return;
+        default:
+            throw std::runtime_error("Unsupported vector transport type");
+    }
+}
+
+// The block versions run the same kernels on subviews of the parent array
+// and write the n x p result into the block through a pooled buffer.
+
+template <typename T>
+double Stiefel<T>::metric_block(const ConstArrayView& x, 
+                                const ConstArrayView& etax, 
+                                const ConstArrayView& xix) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(xix, "xix");
+
+    return metric_impl(metric_type_, x.as<T>(), etax.as<T>(), xix.as<T>());
+}
+
+template <typename T>
+void Stiefel<T>::projection_block(const ConstArrayView& x, 
+                                  const ConstArrayView& etax,
+                                  const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(out, "out");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> result(n, p);
+    projection_into_impl(x.as<T>(), etax.as<T>(), result);
+    out.as<T>() = result;
+}
+
+template <typename T>
+void Stiefel<T>::retraction_block(const ConstArrayView& x, 
+                                  const ConstArrayView& etax,
+                                  const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(out, "out");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> result(n, p);
+    retraction_into_impl(retraction_type_, x.as<T>(), etax.as<T>(), result);
+    out.as<T>() = result;
+}
+
+template <typename T>
+std::unique_ptr<RetractionCurve> Stiefel<T>::retraction_curve(const ManifoldPoint& x, 
+                                                              const ManifoldVector& etax) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_orthogonality(x, "x");
+
+    return std::unique_ptr<RetractionCurve>(
+        new StiefelCurve<T>(*this, x.as<T>(), etax.as<T>()));
+}
+
+template <typename T>
+void Stiefel<T>::retraction_curve_into(const ManifoldPoint& x, 
+                                       const ManifoldVector& etax,
+                                       std::unique_ptr<RetractionCurve>& curve) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_orthogonality(x, "x");
+
+    Manifold::retraction_curve_into(x, etax, curve);
+}
+
+template <typename T>
+void Stiefel<T>::vector_transport_block(const ConstArrayView& x, 
+                                        const ConstArrayView& etax,
+                                        const ConstArrayView& y, 
+                                        const ConstArrayView& xix,
+                                        const ArrayView& out) const {
     check_dimensions(x, "x");
     check_dimensions(etax, "etax");
     check_dimensions(y, "y");
@@ -240,31 +861,266 @@ ManifoldVector Stiefel::vector_transport(const ManifoldPoint& x,
 
     switch (vector_transport_type_) {
         case VT_PROJECTION:
-            return projection(y, xix);
         case VT_PARALLELTRANSLATION:
-            return projection(y, xix);
+            projection_block(y, xix, out);
+            return;
         case VT_CAYLEY: {
-            if (is_complex_) {
-                arma::cx_mat X = x.as_complex();
-                arma::cx_mat Z= etax.as_complex();
-                arma::cx_mat W = Z* X.t() - X * Z.t();
-                arma::cx_mat I = arma::eye<arma::cx_mat>(p, p);
-                arma::cx_mat cayley = arma::solve(I + W/2.0, I - W/2.0);
-                arma::cx_mat result = cayley * xix.as_complex();
-                return ManifoldVector(result);
-            } else {
-                arma::mat X = x.as_mat();
-                arma::mat Z= etax.as_mat();
-                arma::mat W = Z* X.t() - X * Z.t();
-                arma::mat I = arma::eye(p, p);
-                arma::mat cayley = arma::solve(I + W/2.0, I - W/2.0);
-                arma::mat result = cayley * xix.as_mat();
-                return ManifoldVector(result);
-            }
+            check_dimensions(out, "out");
+            PooledMat<T> result(n, p);
+            cayley_transport_into_impl(x.as<T>(), etax.as<T>(), xix.as<T>(), result);
+            out.as<T>() = result;
+            return;
         }
         default:
             throw std::runtime_error("Unsupported vector transport type");
     }
 }
 
-} // namespace OptimLight
\ No newline at end of file
+template <typename T>
+void Stiefel<T>::vector_transport_many(const ManifoldPoint& x, 
+                                       const ManifoldVector& etax,
+                                       const ManifoldPoint& y, 
+                                       const std::vector<ManifoldVector*>& xis) const {
+    vector_transport_many_block(x, etax, y, views_of(xis));
+}
+
+template <typename T>
+void Stiefel<T>::retract_and_transport(const ManifoldPoint& x, 
+                                       const ManifoldVector& etax,
+                                       ManifoldPoint& y, 
+                                       const std::vector<ManifoldVector*>& xis) const {
+    const std::vector<ArrayView>& views = views_of(xis);
+    y.set_size<T>(n, p);
+    retract_and_transport_block(x, etax, y, views);
+}
+
+template <typename T>
+void Stiefel<T>::vector_transport_many_block(const ConstArrayView& x, 
+                                             const ConstArrayView& etax,
+                                             const ConstArrayView& y, 
+                                             const std::vector<ArrayView>& xis) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(y, "y");
+    for (const ArrayView& xi : xis) {
+        check_dimensions(xi, "xi");
+    }
+    check_orthogonality(x, "x");
+    check_orthogonality(y, "y");
+    if (xis.empty()) {
+        return;
+    }
+
+    PooledMat<T> P(n, xis.size() * p);
+    pack<T>(xis, 0, P);
+    transport_packed_impl(vector_transport_type_, x.as<T>(), etax.as<T>(), y.as<T>(), P);
+    unpack(P, 0, xis);
+}
+
+template <typename T>
+void Stiefel<T>::retract_and_transport_block(const ConstArrayView& x, 
+                                             const ConstArrayView& etax,
+                                             const ArrayView& y, 
+                                             const std::vector<ArrayView>& xis) const {
+    check_dimensions(x, "x");
+    check_dimensions(etax, "etax");
+    check_dimensions(y, "y");
+    for (const ArrayView& xi : xis) {
+        check_dimensions(xi, "xi");
+    }
+    check_orthogonality(x, "x");
+
+    // The Cayley retraction is the Cayley transport of X itself, so with
+    // both X goes in as one more block of the same solve
+    const bool fused = retraction_type_ == RT_CAYLEY && vector_transport_type_ == VT_CAYLEY;
+    const la::uword first = fused ? 1 : 0;
+    PooledMat<T> P(n, (xis.size() + first) * p);
+    pack<T>(xis, first, P);
+    if (fused) {
+        la::block(P, 0, 0, n, p) = x.as<T>();
+        cayley_solve(x.as<T>(), etax.as<T>(), P, P);
+        y.as<T>() = la::block(P, 0, 0, n, p);
+    } else {
+        PooledMat<T> Y(n, p);
+        retraction_into_impl(retraction_type_, x.as<T>(), etax.as<T>(), Y);
+        if (!xis.empty()) {
+            transport_packed_impl(vector_transport_type_, x.as<T>(), etax.as<T>(), Y, P);
+        }
+        y.as<T>() = Y;
+    }
+    unpack(P, first, xis);
+}
+
+template <typename T>
+double Stiefel<T>::egrad_to_rgrad(const ManifoldPoint& x, 
+                                  const ManifoldVector& egrad,
+                                  ManifoldVector& rgrad,
+                                  Array* correction) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> M(p, p);
+    la::noalias(M) = la::adjoint(x.as<T>()) * egrad.as<T>();
+    if (correction) {
+        correction->set_size<T>(p, p);
+        correction->as<T>() = M;
+    }
+    rgrad.set_size<T>(n, p);
+    const double norm2 = egrad_to_rgrad_impl(metric_type_, x.as<T>(), egrad.as<T>(), M,
+                                             rgrad.as<T>());
+    return std::sqrt(std::max(norm2, 0.0));
+}
+
+template <typename T>
+void Stiefel<T>::ehess_to_rhess(const ManifoldPoint& x, 
+                                const ManifoldVector& egrad,
+                                const ManifoldVector& ehess,
+                                const ManifoldVector& eta,
+                                ManifoldVector& out,
+                                const Array* correction) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(ehess, "ehess");
+    check_dimensions(eta, "eta");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> M(p, p);
+    if (correction && correction->n_elem() > 0) {
+        if (correction->n_rows() != static_cast<size_t>(p) ||
+            correction->n_cols() != static_cast<size_t>(p)) {
+            throw std::runtime_error("ehess_to_rhess: correction does not belong to " + name);
+        }
+        M = correction->as<T>();
+    } else {
+        la::noalias(M) = la::adjoint(x.as<T>()) * egrad.as<T>();
+    }
+    out.set_size<T>(n, p);
+    ehess_to_rhess_impl(metric_type_, x.as<T>(), egrad.as<T>(), ehess.as<T>(), eta.as<T>(), M,
+                        out.as<T>());
+}
+
+template <typename T>
+double Stiefel<T>::egrad_to_rgrad_block(const ConstArrayView& x, 
+                                        const ConstArrayView& egrad,
+                                        const ArrayView& rgrad) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(rgrad, "rgrad");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> M(p, p), result(n, p);
+    la::noalias(M) = la::adjoint(x.as<T>()) * egrad.as<T>();
+    const double norm2 = egrad_to_rgrad_impl(metric_type_, x.as<T>(), egrad.as<T>(), M, result);
+    rgrad.as<T>() = result;
+    return std::sqrt(std::max(norm2, 0.0));
+}
+
+template <typename T>
+void Stiefel<T>::ehess_to_rhess_block(const ConstArrayView& x, 
+                                      const ConstArrayView& egrad,
+                                      const ConstArrayView& ehess,
+                                      const ConstArrayView& eta,
+                                      const ArrayView& out) const {
+    check_dimensions(x, "x");
+    check_dimensions(egrad, "egrad");
+    check_dimensions(ehess, "ehess");
+    check_dimensions(eta, "eta");
+    check_dimensions(out, "out");
+    check_orthogonality(x, "x");
+
+    PooledMat<T> M(p, p), result(n, p);
+    la::noalias(M) = la::adjoint(x.as<T>()) * egrad.as<T>();
+    ehess_to_rhess_impl(metric_type_, x.as<T>(), egrad.as<T>(), ehess.as<T>(), eta.as<T>(), M,
+                        result);
+    out.as<T>() = result;
+}
+
+template <typename T>
+void Stiefel<T>::check_batch(const ManifoldPoint& x, const char* name,
+                             int first, int count, bool orthogonal) const {
+    if (validation::dimensions_enabled) {
+        if (x.n_rows() != static_cast<size_t>(n) || x.n_cols() % p != 0 ||
+            first < 0 || static_cast<size_t>(first + count) * p > x.n_cols()) {
+            throw std::runtime_error(std::string(name) + " does not hold copies " +
+                                     std::to_string(first) + ".." + std::to_string(first + count) +
+                                     " of " + this->name);
+        }
+        if (x.is_complex() != is_complex()) {
+            throw std::runtime_error(std::string(name) + " has the wrong complex type");
+        }
+    }
+    if (orthogonal) {
+        for (int i = first; i < first + count; ++i) {
+            check_orthogonality(ConstArrayView(x, 0, static_cast<size_t>(i) * p, n, p), name);
+        }
+    }
+}
+
+template <typename T>
+double Stiefel<T>::metric_batch(const ManifoldPoint& x, 
+                                const ManifoldVector& etax, 
+                                const ManifoldVector& xix,
+                                int first, int count) const {
+    check_batch(x, "x", first, count, false);
+    check_batch(etax, "etax", first, count, false);
+    check_batch(xix, "xix", first, count, false);
+
+    return metric_batch_impl(metric_type_, x.as<T>(), etax.as<T>(), xix.as<T>(),
+                             n, p, first, count);
+}
+
+template <typename T>
+void Stiefel<T>::projection_batch(const ManifoldPoint& x, 
+                                  const ManifoldVector& etax,
+                                  ManifoldVector& out,
+                                  int first, int count) const {
+    check_batch(x, "x", first, count, true);
+    check_batch(etax, "etax", first, count, false);
+    check_batch(out, "out", first, count, false);
+
+    projection_batch_impl(x.as<T>(), etax.as<T>(), out.as<T>(), n, p, first, count);
+}
+
+template <typename T>
+void Stiefel<T>::retraction_batch(const ManifoldPoint& x, 
+                                  const ManifoldVector& etax,
+                                  ManifoldPoint& out,
+                                  int first, int count) const {
+    check_batch(x, "x", first, count, true);
+    check_batch(etax, "etax", first, count, false);
+    check_batch(out, "out", first, count, false);
+
+    retraction_batch_impl(retraction_type_, x.as<T>(), etax.as<T>(), out.as<T>(),
+                          n, p, first, count);
+}
+
+template <typename T>
+void Stiefel<T>::vector_transport_batch(const ManifoldPoint& x, 
+                                        const ManifoldVector& etax,
+                                        const ManifoldPoint& y, 
+                                        const ManifoldVector& xix,
+                                        ManifoldVector& out,
+                                        int first, int count) const {
+    switch (vector_transport_type_) {
+        case VT_PROJECTION:
+        case VT_PARALLELTRANSLATION:
+            projection_batch(y, xix, out, first, count);
+            return;
+        case VT_CAYLEY:
+            check_batch(x, "x", first, count, true);
+            check_batch(etax, "etax", first, count, false);
+            check_batch(xix, "xix", first, count, false);
+            check_batch(out, "out", first, count, false);
+            cayley_transport_batch_impl(x.as<T>(), etax.as<T>(), xix.as<T>(), out.as<T>(),
+                                        n, p, first, count);
+            return;
+        default:
+            throw std::runtime_error("Unsupported vector transport type");
+    }
+}
+
+template class Stiefel<double>;
+template class Stiefel<la::cx_double>;
+
+} // namespace OptimLight
@@ -2,8 +2,8 @@
 #define STIEFEL_HPP
 
 #include "manifold.hpp"
+#include "validation.hpp"
 #include <complex>
-#include <armadillo>
 
 namespace OptimLight
 {
@@ -19,6 +19,7 @@ namespace OptimLight
         RT_EXP,     // Exponential mapping
         RT_CAYLEY,  // Cayley transform
         RT_POLAR,   // Polar decomposition
+        RT_POLAR_NS, // Polar decomposition by Newton-Schulz iteration
         RetractionTypeLength
     };
 
@@ -32,16 +33,17 @@ namespace OptimLight
         VectorTransportTypeLength
     };
 
-    class Stiefel : public Manifold
+    // Parts of Stiefel(p, n) that do not depend on the scalar type. The
+    // batched operations are declared here so that StackedManifold can use
+    // them without knowing whether the base is real or complex.
+    class StiefelBase : public Manifold
     {
     public:
-        // Constructor with full parameters
-        // Stiefel();
-        Stiefel(int n_, int p_, bool is_complex = false,
-                MetricType metric_type = CANONICAL,
-                RetractionType retraction_type = RT_QF,
-                VectorTransportType vector_transport_type = VT_PROJECTION)
-            : n(n_), p(p_),  is_complex_(is_complex),
+        StiefelBase(int n_, int p_, bool is_complex,
+                    MetricType metric_type,
+                    RetractionType retraction_type,
+                    VectorTransportType vector_transport_type)
+            : n(n_), p(p_),
               metric_type_(metric_type),
               retraction_type_(retraction_type),
               vector_transport_type_(vector_transport_type) {
@@ -54,31 +56,80 @@ namespace OptimLight
             empty = ManifoldVector(n, p, is_complex);
         }
 
-        // Copy constructor
-        Stiefel(const Stiefel& other)
-            : n(other.n),  p(other.p), is_complex_(other.is_complex_),
-              metric_type_(other.metric_type_),
-              retraction_type_(other.retraction_type_),
-              vector_transport_type_(other.vector_transport_type_) {
-            name = other.name;
-            empty = other.empty;
+        // Batched operations on the copies first..first+count-1 of a stacked
+        // point. The copies are n x p blocks side by side in an
+        // n x (p * copies) array, copy i in columns [i*p, (i+1)*p), which is
+        // the memory layout of an n x p x copies cube, so every copy is
+        // contiguous. `out` must already have the full stacked size; it may
+        // alias the tangent vector argument. Used by StackedManifold.
+        virtual double metric_batch(const ManifoldPoint& x, 
+                                    const ManifoldVector& etax, 
+                                    const ManifoldVector& xix,
+                                    int first, int count) const = 0;
+
+        virtual void projection_batch(const ManifoldPoint& x, 
+                                      const ManifoldVector& etax,
+                                      ManifoldVector& out,
+                                      int first, int count) const = 0;
+
+        virtual void retraction_batch(const ManifoldPoint& x, 
+                                      const ManifoldVector& etax,
+                                      ManifoldPoint& out,
+                                      int first, int count) const = 0;
+
+        virtual void vector_transport_batch(const ManifoldPoint& x, 
+                                            const ManifoldVector& etax,
+                                            const ManifoldPoint& y, 
+                                            const ManifoldVector& xix,
+                                            ManifoldVector& out,
+                                            int first, int count) const = 0;
+
+        int dimension() const  {
+            return p * n;
+        }
+
+        int intrinsic_dimension() const  {
+            return p * n - p * (p + 1) / 2;
         }
 
-        // Assignment operator
-        Stiefel& operator=(const Stiefel& other) {
-            if (this != &other) {
-                p = other.p;
-                n = other.n;
-                is_complex_ = other.is_complex_;
-                metric_type_ = other.metric_type_;
-                retraction_type_ = other.retraction_type_;
-                vector_transport_type_ = other.vector_transport_type_;
-                name = other.name;
-                empty = other.empty;
-            }
-            return *this;
+        // The kernels are dominated by n x p times p x p products
+        double cost_estimate() const override {
+            return static_cast<double>(n) * p * p;
         }
 
+        // Setters for different types
+        void set_metric_type(MetricType type) { metric_type_ = type; }
+        void set_retraction_type(RetractionType type) { retraction_type_ = type; }
+        void set_vector_transport_type(VectorTransportType type) { vector_transport_type_ = type; }
+        RetractionType get_retraction_type() const { return retraction_type_; }
+
+        int n;  // Number of rows 
+        int p;  // Number of columns
+
+    protected:
+        void check_dimensions(const ConstArrayView& x, const char* name) const;
+
+        MetricType metric_type_;
+        RetractionType retraction_type_;
+        VectorTransportType vector_transport_type_;
+    };
+
+    // Stiefel(p, n) over the scalar type T, double or la::cx_double. Points
+    // and tangent vectors must hold T; every kernel is compiled for T alone,
+    // so the real manifold never branches on or instantiates complex code.
+    // Stiefel<double> and Stiefel<la::cx_double> are instantiated in
+    // stiefel.cpp.
+    template <typename T>
+    class Stiefel : public StiefelBase
+    {
+    public:
+        Stiefel(int n_, int p_,
+                MetricType metric_type = CANONICAL,
+                RetractionType retraction_type = RT_QF,
+                VectorTransportType vector_transport_type = VT_PROJECTION)
+            : StiefelBase(n_, p_, la::is_complex<T>::value,
+                          metric_type, retraction_type, vector_transport_type) {}
+
         double metric(const ManifoldPoint& x, 
                      const ManifoldVector& etax, 
                      const ManifoldVector& xix) const override;
@@ -94,35 +145,127 @@ namespace OptimLight
                                       const ManifoldPoint& y, 
                                       const ManifoldVector& xix) const override;
 
-        int dimension() const  {
-            return p * n;
-        }
+        void projection_into(const ManifoldPoint& x, 
+                             const ManifoldVector& etax,
+                             ManifoldVector& out) const override;
 
-        int intrinsic_dimension() const  {
-            return p * n - p * (p + 1) / 2;
-        }
+        // Allocation-free in the steady state only with RT_POLAR_NS. RT_QF,
+        // the default, RT_EXP, RT_CAYLEY and RT_POLAR call a QR
+        // factorisation, a matrix exponential, an LU solve or an eigen
+        // decomposition of the backend, which allocates its workspace on
+        // every call; so does VT_CAYLEY in vector_transport_into.
+        void retraction_into(const ManifoldPoint& x, 
+                             const ManifoldVector& etax,
+                             ManifoldPoint& out) const override;
 
-        // Setters for different types
-        void set_metric_type(MetricType type) { metric_type_ = type; }
-        void set_retraction_type(RetractionType type) { retraction_type_ = type; }
-        void set_vector_transport_type(VectorTransportType type) { vector_transport_type_ = type; }
-        
-        // Getters for manifold properties
-        bool is_complex() const { return is_complex_; }
+        void vector_transport_into(const ManifoldPoint& x, 
+                                   const ManifoldVector& etax,
+                                   const ManifoldPoint& y, 
+                                   const ManifoldVector& xix,
+                                   ManifoldVector& out) const override;
 
-        int n;  // Number of rows 
-        int p;  // Number of columns
+        double metric_block(const ConstArrayView& x, 
+                            const ConstArrayView& etax, 
+                            const ConstArrayView& xix) const override;
 
-        bool is_complex_;
+        void projection_block(const ConstArrayView& x, 
+                              const ConstArrayView& etax,
+                              const ArrayView& out) const override;
 
-    private:
-        void check_dimensions(const ManifoldPoint& x, const std::string& name) const;
-        void check_orthogonality(const ManifoldPoint& x, const std::string& name, double tol = 1e-10) const;
-        void symmatu(arma::mat& result, const arma::mat& X) const;
+        void retraction_block(const ConstArrayView& x, 
+                              const ConstArrayView& etax,
+                              const ArrayView& out) const override;
 
-        MetricType metric_type_;
-        RetractionType retraction_type_;
-        VectorTransportType vector_transport_type_;
+        void vector_transport_block(const ConstArrayView& x, 
+                                    const ConstArrayView& etax,
+                                    const ConstArrayView& y, 
+                                    const ConstArrayView& xix,
+                                    const ArrayView& out) const override;
+
+        // Transport all the vectors in one pass, see transport_packed_impl
+        // in stiefel.cpp. With RT_CAYLEY and VT_CAYLEY the retraction and
+        // the transports are a single solve.
+        void vector_transport_many(const ManifoldPoint& x, 
+                                   const ManifoldVector& etax,
+                                   const ManifoldPoint& y, 
+                                   const std::vector<ManifoldVector*>& xis) const override;
+
+        void retract_and_transport(const ManifoldPoint& x, 
+                                   const ManifoldVector& etax,
+                                   ManifoldPoint& y, 
+                                   const std::vector<ManifoldVector*>& xis) const override;
+
+        void vector_transport_many_block(const ConstArrayView& x, 
+                                         const ConstArrayView& etax,
+                                         const ConstArrayView& y, 
+                                         const std::vector<ArrayView>& xis) const override;
+
+        void retract_and_transport_block(const ConstArrayView& x, 
+                                         const ConstArrayView& etax,
+                                         const ArrayView& y, 
+                                         const std::vector<ArrayView>& xis) const override;
+
+        // Factorises the retraction once for all t, see StiefelCurve in
+        // stiefel.cpp
+        std::unique_ptr<RetractionCurve> retraction_curve(const ManifoldPoint& x, 
+                                                          const ManifoldVector& etax) const override;
+        void retraction_curve_into(const ManifoldPoint& x, 
+                                   const ManifoldVector& etax,
+                                   std::unique_ptr<RetractionCurve>& curve) const override;
+
+        // The correction is the p x p matrix X^H egrad, which both the
+        // gradient and the Hessian conversion need
+        double egrad_to_rgrad(const ManifoldPoint& x, 
+                              const ManifoldVector& egrad,
+                              ManifoldVector& rgrad,
+                              Array* correction = nullptr) const override;
+
+        void ehess_to_rhess(const ManifoldPoint& x, 
+                            const ManifoldVector& egrad,
+                            const ManifoldVector& ehess,
+                            const ManifoldVector& eta,
+                            ManifoldVector& out,
+                            const Array* correction = nullptr) const override;
+
+        double egrad_to_rgrad_block(const ConstArrayView& x, 
+                                    const ConstArrayView& egrad,
+                                    const ArrayView& rgrad) const override;
+
+        void ehess_to_rhess_block(const ConstArrayView& x, 
+                                  const ConstArrayView& egrad,
+                                  const ConstArrayView& ehess,
+                                  const ConstArrayView& eta,
+                                  const ArrayView& out) const override;
+
+        double metric_batch(const ManifoldPoint& x, 
+                            const ManifoldVector& etax, 
+                            const ManifoldVector& xix,
+                            int first, int count) const override;
+
+        void projection_batch(const ManifoldPoint& x, 
+                              const ManifoldVector& etax,
+                              ManifoldVector& out,
+                              int first, int count) const override;
+
+        void retraction_batch(const ManifoldPoint& x, 
+                              const ManifoldVector& etax,
+                              ManifoldPoint& out,
+                              int first, int count) const override;
+
+        void vector_transport_batch(const ManifoldPoint& x, 
+                                    const ManifoldVector& etax,
+                                    const ManifoldPoint& y, 
+                                    const ManifoldVector& xix,
+                                    ManifoldVector& out,
+                                    int first, int count) const override;
+
+        // Getters for manifold properties
+        bool is_complex() const { return la::is_complex<T>::value; }
+
+    private:
+        void check_orthogonality(const ConstArrayView& x, const char* name, double tol = 1e-10) const;
+        void check_batch(const ManifoldPoint& x, const char* name,
+                         int first, int count, bool orthogonal) const;
     };
 }
 
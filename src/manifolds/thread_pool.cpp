@@ -0,0 +1,154 @@
+#include "thread_pool.hpp"
+
+namespace OptimLight {
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i - 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ThreadPool::pop_front(WorkQueue& queue, size_t& item) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) {
+        return false;
+    }
+    item = queue.items.front();
+    queue.items.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal_back(WorkQueue& queue, size_t& item) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) {
+        return false;
+    }
+    item = queue.items.back();
+    queue.items.pop_back();
+    return true;
+}
+
+void ThreadPool::work(Job& job, size_t id) {
+    const size_t num_queues = job.queues.size();
+    size_t item;
+    while (true) {
+        bool found = pop_front(*job.queues[id], item);
+        for (size_t k = 1; !found && k < num_queues; ++k) {
+            found = steal_back(*job.queues[(id + k) % num_queues], item);
+        }
+        if (!found) {
+            return;
+        }
+        try {
+            (*job.task)(item);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.error_mutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void ThreadPool::worker_loop(size_t id) {
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+            return;
+        }
+        seen = generation_;
+        Job* job = job_;
+        if (!job) {
+            continue;  // woke up after that job already finished
+        }
+        ++active_;
+        lock.unlock();
+        work(*job, id);
+        lock.lock();
+        --active_;
+        done_.notify_all();
+    }
+}
+
+void ThreadPool::run_inline(const std::vector<size_t>& order,
+                            const std::function<void(size_t)>& task) {
+    std::exception_ptr error;
+    for (size_t item : order) {
+        try {
+            task(item);
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::run(const std::vector<size_t>& order,
+                     const std::function<void(size_t)>& task) {
+    if (order.empty()) {
+        return;
+    }
+    if (busy_.exchange(true, std::memory_order_acquire)) {
+        run_inline(order, task);
+        return;
+    }
+    // Releases the workers however this call ends
+    struct Release {
+        std::atomic<bool>& busy;
+        ~Release() { busy.store(false, std::memory_order_release); }
+    } release{busy_};
+
+    Job job;
+    job.task = &task;
+    job.remaining.store(order.size());
+    const size_t participants = size();
+    for (size_t i = 0; i < participants; ++i) {
+        job.queues.emplace_back(new WorkQueue());
+    }
+    for (size_t k = 0; k < order.size(); ++k) {
+        job.queues[k % participants]->items.push_back(order[k]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    // The caller owns the last queue
+    work(job, participants - 1);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&] { return active_ == 0 && job.remaining.load() == 0; });
+        job_ = nullptr;
+    }
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+} // namespace OptimLight
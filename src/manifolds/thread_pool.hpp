@@ -0,0 +1,85 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OptimLight {
+
+// Fixed-size pool of worker threads with work stealing.
+//
+// run() deals the task indices round-robin, in the order given, onto one
+// queue per participant: the workers and the calling thread, which joins
+// in. Every participant takes tasks from the front of its own queue and,
+// once that is empty, steals from the back of the others. If the order is
+// sorted by decreasing cost, each thread starts on the most expensive
+// tasks and the cheap ones at the tail even out the load.
+class ThreadPool {
+public:
+    // num_threads counts the calling thread, so num_threads - 1 workers are
+    // started. 0 means std::thread::hardware_concurrency().
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads taking part in run(), the caller included
+    size_t size() const { return workers_.size() + 1; }
+
+    // Call task(i) for every i in `order` and wait until all are done.
+    // The first exception thrown by a task is rethrown here once the
+    // remaining tasks have finished.
+    //
+    // Only one run() uses the workers at a time. A call made while the pool
+    // is busy, from another thread or from inside a task, runs its tasks
+    // inline on the calling thread instead, so copies of a manifold sharing
+    // the pool, or the same manifold listed twice in a threaded product,
+    // stay correct without waiting on each other.
+    //
+    // A run() that uses the workers heap-allocates its Job and one queue
+    // per participant, so threaded execution is not allocation-free.
+    void run(const std::vector<size_t>& order, const std::function<void(size_t)>& task);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    struct Job {
+        const std::function<void(size_t)>* task;
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::atomic<size_t> remaining;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    static void run_inline(const std::vector<size_t>& order,
+                           const std::function<void(size_t)>& task);
+    void worker_loop(size_t id);
+    void work(Job& job, size_t id);
+    static bool pop_front(WorkQueue& queue, size_t& item);
+    static bool steal_back(WorkQueue& queue, size_t& item);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    Job* job_ = nullptr;
+    unsigned long generation_ = 0;
+    size_t active_ = 0;
+    bool stop_ = false;
+    std::atomic<bool> busy_{false};  // A run() owns the workers
+};
+
+} // namespace OptimLight
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,53 @@
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+// Compile-time policy for the input checks done by the manifold operations.
+//
+//   OPTIMLIGHT_VALIDATION_FULL     every dimension and orthogonality check
+//   OPTIMLIGHT_VALIDATION_SAMPLED  dimension checks on every call, the
+//                                  O(np^2) orthogonality check on every
+//                                  OPTIMLIGHT_VALIDATION_INTERVAL-th call
+//   OPTIMLIGHT_VALIDATION_NONE     no checks at all
+//
+// When OPTIMLIGHT_VALIDATION is not set, builds without NDEBUG use FULL and
+// builds with NDEBUG use NONE.
+
+#define OPTIMLIGHT_VALIDATION_NONE 0
+#define OPTIMLIGHT_VALIDATION_SAMPLED 1
+#define OPTIMLIGHT_VALIDATION_FULL 2
+
+#ifndef OPTIMLIGHT_VALIDATION
+#ifdef NDEBUG
+#define OPTIMLIGHT_VALIDATION OPTIMLIGHT_VALIDATION_NONE
+#else
+#define OPTIMLIGHT_VALIDATION OPTIMLIGHT_VALIDATION_FULL
+#endif
+#endif
+
+#ifndef OPTIMLIGHT_VALIDATION_INTERVAL
+#define OPTIMLIGHT_VALIDATION_INTERVAL 64
+#endif
+
+namespace OptimLight {
+namespace validation {
+
+// Whether dimension checks are compiled in
+constexpr bool dimensions_enabled = OPTIMLIGHT_VALIDATION >= OPTIMLIGHT_VALIDATION_SAMPLED;
+
+// Whether an expensive check (e.g. orthogonality) should run on this call.
+// Sampling counts calls per thread.
+inline bool sample_expensive() {
+#if OPTIMLIGHT_VALIDATION == OPTIMLIGHT_VALIDATION_FULL
+    return true;
+#elif OPTIMLIGHT_VALIDATION == OPTIMLIGHT_VALIDATION_SAMPLED
+    thread_local unsigned long calls = 0;
+    return calls++ % OPTIMLIGHT_VALIDATION_INTERVAL == 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace validation
+} // namespace OptimLight
+
+#endif // VALIDATION_HPP
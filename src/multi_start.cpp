@@ -0,0 +1,160 @@
+#include "multi_start.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+struct MultiStart::Workspace
+{
+    Workspace(const Problem* problem, Algorithm algorithm) : optimizer(problem, algorithm) {}
+
+    Optimizer optimizer;
+    ManifoldPoint x;
+    // f of the last prune_window + 1 iterates, by iteration modulo its size
+    std::vector<double> history;
+};
+
+MultiStart::MultiStart(const Problem* problem, Algorithm algorithm)
+    : problem_(problem), algorithm_(algorithm), max_iter_(1000), tol_(1e-6), max_time_(0.0),
+      prune_gap_(0.1), prune_window_(10), best_(std::numeric_limits<double>::infinity()),
+      best_value_(std::numeric_limits<double>::infinity()), best_index_(-1)
+{
+}
+
+MultiStart::~MultiStart() = default;
+
+void MultiStart::set_num_threads(int num_threads)
+{
+    if (num_threads > 1) {
+        pool_ = std::make_shared<ThreadPool>(num_threads);
+    } else {
+        pool_.reset();
+    }
+}
+
+int MultiStart::get_num_threads() const
+{
+    return pool_ ? static_cast<int>(pool_->size()) : 1;
+}
+
+int MultiStart::num_pruned() const
+{
+    return static_cast<int>(std::count_if(outcomes_.begin(), outcomes_.end(), [](const Outcome& o) {
+        return o.result == Result::RESULT_STOPPED;
+    }));
+}
+
+int MultiStart::run(const std::vector<ManifoldPoint>& starts)
+{
+    if (starts.empty()) {
+        throw std::runtime_error("MultiStart: no starting points");
+    }
+    const size_t threads = pool_ ? pool_->size() : 1;
+    while (idle_.size() < threads) {
+        idle_.emplace_back(new Workspace(problem_, algorithm_));
+    }
+
+    // The starting values, from one batched call. Every start ends at or
+    // below its starting value, so the lowest one already bounds the best,
+    // and running the starts from the lowest up lowers the bound early.
+    std::vector<const ManifoldPoint*> points(starts.size());
+    for (size_t i = 0; i < starts.size(); ++i) {
+        points[i] = &starts[i];
+    }
+    std::vector<double> values;
+    problem_->objective_batch(points, values);
+    std::vector<size_t> order(starts.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&values](size_t a, size_t b) {
+        return values[a] < values[b] || (!std::isnan(values[a]) && std::isnan(values[b]));
+    });
+
+    best_.store(std::numeric_limits<double>::infinity());
+    for (double value : values) {
+        lower_best(value);
+    }
+    best_value_ = std::numeric_limits<double>::infinity();
+    best_index_ = -1;
+    outcomes_.assign(starts.size(), Outcome{Result::RESULT_DIDNOTRUN, std::nan(""), 0});
+
+    if (pool_ && starts.size() > 1) {
+        pool_->run(order, [&](size_t i) { run_start(starts[i], static_cast<int>(i)); });
+    } else {
+        for (size_t i : order) {
+            run_start(starts[i], static_cast<int>(i));
+        }
+    }
+    return best_index_;
+}
+
+void MultiStart::run_start(const ManifoldPoint& start, int index)
+{
+    std::unique_ptr<Workspace> ws;
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        ws = std::move(idle_.back());
+        idle_.pop_back();
+    }
+
+    Workspace& w = *ws;
+    w.x = start;
+    w.history.assign(prune_window_ + 1, 0.0);
+    Optimizer& optimizer = w.optimizer;
+    optimizer.set_max_iter(max_iter_);
+    optimizer.set_tol(tol_);
+    optimizer.set_max_time(max_time_);
+    optimizer.get_solver().set_monitor([this, &w](int iter, double f, double) {
+        lower_best(f);
+        return keep_going(w, iter, f);
+    });
+
+    const Result result = optimizer.run(w.x);
+    const Solver& solver = optimizer.get_solver();
+    const double f = solver.f_value();
+    lower_best(f);
+    outcomes_[index] = Outcome{result, f, solver.iterations()};
+
+    // NaN never wins; ties go to the lower index
+    const double key = std::isnan(f) ? std::numeric_limits<double>::infinity() : f;
+    {
+        std::lock_guard<std::mutex> lock(best_mutex_);
+        if (best_index_ < 0 || key < best_value_ || (key == best_value_ && index < best_index_)) {
+            best_value_ = key;
+            best_index_ = index;
+            best_point_ = w.x;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    idle_.push_back(std::move(ws));
+}
+
+void MultiStart::lower_best(double value)
+{
+    double current = best_.load(std::memory_order_relaxed);
+    while (value < current &&
+           !best_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+bool MultiStart::keep_going(Workspace& ws, int iter, double f) const
+{
+    const int size = prune_window_ + 1;
+    ws.history[iter % size] = f;
+    if (prune_gap_ < 0.0 || iter <= prune_window_) {
+        return true;
+    }
+    const double best = best_.load(std::memory_order_relaxed);
+    const double gap = f - best;
+    if (!(gap > prune_gap_ * std::max(1.0, std::abs(best)))) {
+        return true;
+    }
+    const double decrease = ws.history[(iter - prune_window_) % size] - f;
+    return decrease >= gap;
+}
+
+} // namespace OptimLight
@@ -0,0 +1,110 @@
+#ifndef MULTI_START_HPP
+#define MULTI_START_HPP
+
+#include "types.hpp"
+#include "problem.hpp"
+#include "optimizer.hpp"
+#include "manifolds/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace OptimLight
+{
+
+// Minimizes from many starting points on a thread pool and keeps the best
+// local minimum, for non-convex problems.
+//
+// Each thread runs its starts with its own workspace, an Optimizer with its
+// solver state, work vectors and evaluation cache, so nothing but the best
+// value is shared between starts. That value is an atomic updated without
+// locks after every iteration of every start. A start is cut short with
+// RESULT_STOPPED once it is clearly losing: after prune_window iterations
+// its value is still above the best by more than
+// prune_gap * max(1, |best|), and its decrease over the last prune_window
+// iterations is smaller than that gap, so at its current pace it would not
+// catch up within as many iterations again.
+//
+// The problem and its manifold are called from several threads at once, so
+// their const operations must be thread-safe. The library manifolds are;
+// a threaded ProductManifold or StackedManifold runs the operations that
+// find its pool busy inline on the calling thread.
+class MultiStart
+{
+public:
+    // How one start ended
+    struct Outcome {
+        Result result;
+        double value;
+        int iterations;
+    };
+
+    MultiStart(const Problem* problem, Algorithm algorithm = Algorithm::ALGORITHM_LBFGS);
+    ~MultiStart();
+
+    // Threads running starts, the caller included. 1 or less runs the
+    // starts one after the other on the calling thread.
+    void set_num_threads(int num_threads);
+    int get_num_threads() const;
+
+    // Stopping criteria of every start, see Optimizer
+    void set_max_iter(int max_iter) { max_iter_ = max_iter; }
+    void set_tol(double tol) { tol_ = tol; }
+    void set_max_time(double max_time) { max_time_ = max_time; }
+
+    // Pruning of losing starts, see above. A negative gap turns it off.
+    void set_prune_gap(double prune_gap) { prune_gap_ = prune_gap; }
+    void set_prune_window(int prune_window) { prune_window_ = std::max(prune_window, 1); }
+
+    // Minimize from every point of `starts` and return the index of the
+    // start that reached the lowest value, the lowest index among equal
+    // values. The starting values come first, from one
+    // Problem::objective_batch call: the starts run from the lowest
+    // starting value up, and the lowest one seeds the best value. Which
+    // starts get pruned depends on the order in which the threads reach
+    // their iterates, so with pruning on the outcomes can vary from run to
+    // run. Throws if starts is empty.
+    int run(const std::vector<ManifoldPoint>& starts);
+
+    // Results of the last run
+    const ManifoldPoint& best_point() const { return best_point_; }
+    double best_value() const { return best_value_; }
+    int best_index() const { return best_index_; }
+    const std::vector<Outcome>& outcomes() const { return outcomes_; }
+    int num_pruned() const;
+
+private:
+    struct Workspace;
+
+    const Problem* problem_;
+    Algorithm algorithm_;
+    int max_iter_;
+    double tol_;
+    double max_time_;
+    double prune_gap_;
+    int prune_window_;
+    std::shared_ptr<ThreadPool> pool_; // Null for sequential execution
+
+    // Workspaces not in use, one per thread; taken for the length of a start
+    std::vector<std::unique_ptr<Workspace>> idle_;
+    std::mutex idle_mutex_;
+
+    // Lowest value reached by any iterate of any start so far
+    std::atomic<double> best_;
+
+    ManifoldPoint best_point_;
+    double best_value_;
+    int best_index_;
+    std::mutex best_mutex_;
+    std::vector<Outcome> outcomes_;
+
+    void run_start(const ManifoldPoint& start, int index);
+    void lower_best(double value);
+    bool keep_going(Workspace& ws, int iter, double f) const;
+};
+
+} // namespace OptimLight
+
+#endif // MULTI_START_HPP
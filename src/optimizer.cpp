@@ -1 +1,38 @@
-#include "optimizer.hpp"
\ No newline at end of file
+#include "optimizer.hpp"
+#include "optimizers/line_search/lbfgs.hpp"
+#include "optimizers/trust_region/trust_region.hpp"
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+Optimizer::Optimizer(const Problem * problem, Algorithm algorithm_in)
+    : algorithm(algorithm_in), max_iter(1000), tol(1e-6), max_time(0.0),
+      verbose(Verbose::VERBOSE_LOW)
+{
+    switch (algorithm) {
+        case Algorithm::ALGORITHM_LBFGS:
+            method.reset(new LBFGS(problem));
+            break;
+        case Algorithm::ALGORITHM_TR:
+        case Algorithm::ALGORITHM_TNEWTON:
+            method.reset(new TrustRegion(problem));
+            break;
+        default:
+            throw std::runtime_error("Optimizer: " + algorithm_to_string(algorithm) +
+                                     " is not implemented");
+    }
+}
+
+Optimizer::~Optimizer() = default;
+
+Result Optimizer::run(ManifoldPoint & x)
+{
+    method->set_max_iter(max_iter);
+    method->set_gtol(tol);
+    method->set_max_time(max_time);
+    method->set_verbose(verbose);
+    return method->minimize(x);
+}
+
+} // namespace OptimLight
@@ -2,22 +2,46 @@
 #define OPTIMIZER_HPP
 
 #include "types.hpp"
+#include "problem.hpp"
+#include "optimizers/solver.hpp"
+#include <memory>
 
 namespace OptimLight
 {
 
+// Front end that picks the solver for an Algorithm and runs it with the
+// common stopping criteria. The solver itself (see Solver) drives the
+// iterations, enforces the wall-clock budget and collects per-phase timings.
 class Optimizer
 {
     public:
-        Optimizer();
+        // ALGORITHM_LBFGS and ALGORITHM_TR (also used for ALGORITHM_TNEWTON)
+        // are implemented; other algorithms throw
+        Optimizer(const Problem * problem, Algorithm algorithm = Algorithm::ALGORITHM_LBFGS);
         ~Optimizer();
 
+        // Minimize from x, which is overwritten with the result
+        Result run(ManifoldPoint & x);
+
+        void set_max_iter(int max_iter_in) { max_iter = max_iter_in; }
+        void set_tol(double tol_in) { tol = tol_in; }
+        // Wall-clock budget in seconds, <= 0 for none
+        void set_max_time(double max_time_in) { max_time = max_time_in; }
+        void set_verbose(Verbose verbose_in) { verbose = verbose_in; }
+
+        Algorithm get_algorithm() const { return algorithm; }
+        // The solver, for algorithm-specific settings
+        Solver & get_solver() { return *method; }
+        // Timings and counts of the last run
+        const SolverStats & stats() const { return method->stats(); }
 
     private:
+        Algorithm algorithm;
         int max_iter;
         double tol;
-        bool verbose;
-        OptimizerMethod * method;
+        double max_time;
+        Verbose verbose;
+        std::unique_ptr<Solver> method;
 };
 
 
@@ -25,4 +49,4 @@ class Optimizer
 
 } // namespace OptimLight
 
-#endif // OPTIMIZER_HPP
\ No newline at end of file
+#endif // OPTIMIZER_HPP
@@ -0,0 +1,138 @@
+#include "lbfgs.hpp"
+#include "../vector_ops.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+LBFGS::LBFGS(const Problem* problem, int memory)
+    : Solver(problem), memory_(memory),
+      line_search_(LineSearch::LINESEARCH_WOLFE),
+      head_(0), count_(0), gamma_(1.0)
+{
+    if (memory_ < 1) {
+        throw std::runtime_error("LBFGS memory must be positive");
+    }
+}
+
+void LBFGS::start(const ManifoldPoint& x)
+{
+    if (static_cast<int>(s_.size()) != memory_ ||
+        s_[0].n_rows() != x.n_rows() || s_[0].n_cols() != x.n_cols() ||
+        s_[0].is_complex() != x.is_complex()) {
+        s_.assign(memory_, ManifoldVector(x.n_rows(), x.n_cols(), x.is_complex()));
+        y_.assign(memory_, ManifoldVector(x.n_rows(), x.n_cols(), x.is_complex()));
+        rho_.assign(memory_, 0.0);
+        alpha_.assign(memory_, 0.0);
+    }
+    dir_.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    transported_.reserve(2 * memory_);
+    line_search_.set_stats(timers());
+    clear_memory();
+}
+
+void LBFGS::clear_memory()
+{
+    head_ = 0;
+    count_ = 0;
+    gamma_ = 1.0;
+}
+
+void LBFGS::two_loop(const ManifoldPoint& x)
+{
+    dir_ = grad_;
+    for (int age = 0; age < count_; ++age) {
+        int k = slot(age);
+        alpha_[k] = rho_[k] * manifold_->metric(x, s_[k], dir_);
+        axpy(-alpha_[k], y_[k], dir_);
+    }
+    dir_ *= gamma_;
+    for (int age = count_ - 1; age >= 0; --age) {
+        int k = slot(age);
+        double beta = rho_[k] * manifold_->metric(x, y_[k], dir_);
+        axpy(alpha_[k] - beta, s_[k], dir_);
+    }
+    dir_ *= -1.0;
+}
+
+void LBFGS::update_memory(const ManifoldPoint& x, const ManifoldVector& step,
+                          const ManifoldPoint& y, const ManifoldVector& g_y)
+{
+    ScopedTimer timer(timers(), PHASE_TRANSPORT);
+
+    // When the buffer is full the oldest pair is about to be overwritten, so
+    // it is not transported.
+    const int keep = count_ < memory_ ? count_ : memory_ - 1;
+    transported_.clear();
+    for (int age = 0; age < keep; ++age) {
+        int k = slot(age);
+        transported_.push_back(&s_[k]);
+        transported_.push_back(&y_[k]);
+    }
+
+    // New pair, written straight into the oldest slot and transported with
+    // the others: s = T(step), y = g_y - T(grad)
+    int k = head_;
+    s_[k] = step;
+    y_[k] = grad_;
+    transported_.push_back(&s_[k]);
+    transported_.push_back(&y_[k]);
+    manifold_->vector_transport_many(x, step, y, transported_);
+    axpby(1.0, g_y, -1.0, y_[k]);
+
+    double sy = manifold_->metric(y, s_[k], y_[k]);
+    double yy = manifold_->metric(y, y_[k], y_[k]);
+    double ss = manifold_->metric(y, s_[k], s_[k]);
+    // Keep the pair only if it satisfies the curvature condition, which keeps
+    // the implicit inverse Hessian positive definite
+    if (sy > 1e-10 * std::sqrt(ss * yy)) {
+        rho_[k] = 1.0 / sy;
+        gamma_ = sy / yy;
+        head_ = (head_ + 1) % memory_;
+        if (count_ < memory_) {
+            ++count_;
+        }
+    } else if (count_ == memory_) {
+        // The oldest slot was overwritten, drop it
+        --count_;
+    }
+}
+
+bool LBFGS::iterate(ManifoldPoint& x, Result& stop)
+{
+    two_loop(x);
+    double slope = manifold_->metric(x, grad_, dir_);
+    if (!(slope < 0.0)) {
+        // Not a descent direction, restart from steepest descent
+        clear_memory();
+        two_loop(x);
+        slope = -gnorm_ * gnorm_;
+    }
+
+    if (!line_search_.search(cache_, x, dir_, f_, slope)) {
+        if (count_ == 0) {
+            // Even steepest descent made no progress
+            stop = Result::RESULT_FTOL_REACHED;
+        }
+        clear_memory();
+        return false;
+    }
+
+    // The line search already evaluated the new point, and with the
+    // Wolfe conditions also its gradient; otherwise the cache still
+    // holds the point's context for the gradient to build on
+    const ManifoldPoint& y = line_search_.point();
+    const ManifoldVector& g_y = line_search_.has_gradient() ? line_search_.gradient()
+                                                            : cache_.riemannian_gradient(y);
+    update_memory(x, line_search_.step_vector(), y, g_y);
+
+    x = y;
+    grad_ = g_y;
+    f_ = line_search_.value();
+    gnorm_ = cache_.riemannian_gradient_norm(x);
+    return true;
+}
+
+} // namespace OptimLight
@@ -0,0 +1,70 @@
+#ifndef LBFGS_HPP
+#define LBFGS_HPP
+
+#include "../solver.hpp"
+#include "line_search_base.hpp"
+#include <vector>
+
+namespace OptimLight
+{
+
+// Riemannian limited-memory BFGS.
+//
+// The last `memory` pairs (s_k, y_k) are kept in a ring buffer of tangent
+// vectors that is allocated once, at the start of minimize(), together with
+// the other work vectors. After every step the stored pairs are moved to the
+// new tangent space in place, all of them in one vector_transport_many call
+// so that the manifold can share its factorisations across the memory, and
+// an iteration allocates nothing in the solver itself.
+class LBFGS : public Solver
+{
+public:
+    explicit LBFGS(const Problem* problem, int memory = 10);
+
+    // Step size selection, weak Wolfe by default so that the new curvature
+    // pair normally satisfies <s, y> > 0
+    LineSearcher& line_search() { return line_search_; }
+
+    int memory() const { return memory_; }
+    // Curvature pairs held after the last run; a pair whose <s, y> is not
+    // positive is skipped instead of stored
+    int stored_pairs() const { return count_; }
+
+protected:
+    void start(const ManifoldPoint& x) override;
+    bool iterate(ManifoldPoint& x, Result& stop) override;
+    const char* name() const override { return "LBFGS"; }
+
+private:
+    int memory_;
+    LineSearcher line_search_;
+
+    // Ring buffer of the curvature pairs, newest at (head_ - 1) mod memory_
+    std::vector<ManifoldVector> s_;
+    std::vector<ManifoldVector> y_;
+    std::vector<double> rho_;
+    std::vector<double> alpha_;
+    int head_;
+    int count_;
+    double gamma_; // Initial inverse Hessian scaling <s, y> / <y, y>
+
+    // Work vector, reused across iterations
+    ManifoldVector dir_;
+    // The vectors handed to vector_transport_many
+    std::vector<ManifoldVector*> transported_;
+
+    void clear_memory();
+    int slot(int age) const { return (head_ - 1 - age + 2 * memory_) % memory_; }
+
+    // dir = -H grad by the two-loop recursion
+    void two_loop(const ManifoldPoint& x);
+
+    // Move the stored pairs from T_x to T_y, y = R_x(step), and append the
+    // new pair built from the gradient g_y at y
+    void update_memory(const ManifoldPoint& x, const ManifoldVector& step,
+                       const ManifoldPoint& y, const ManifoldVector& g_y);
+};
+
+} // namespace OptimLight
+
+#endif // LBFGS_HPP
@@ -0,0 +1,276 @@
+#include "line_search_base.hpp"
+#include "../vector_ops.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+namespace {
+
+// Minimizer of the cubic interpolating (a, fa, ga) and (b, fb, gb), or NaN
+// if it has no local minimizer
+double cubic_minimizer(double a, double fa, double ga, double b, double fb, double gb)
+{
+    const double d1 = ga + gb - 3.0 * (fa - fb) / (a - b);
+    const double disc = d1 * d1 - ga * gb;
+    if (disc < 0.0) {
+        return std::nan("");
+    }
+    const double d2 = (b > a ? 1.0 : -1.0) * std::sqrt(disc);
+    const double denom = gb - ga + 2.0 * d2;
+    if (denom == 0.0) {
+        return std::nan("");
+    }
+    return b - (b - a) * (gb + d2 - d1) / denom;
+}
+
+// Minimizer of the quadratic interpolating (a, fa, ga) and (b, fb)
+double quadratic_minimizer(double a, double fa, double ga, double b, double fb)
+{
+    const double h = b - a;
+    const double curv = fb - fa - ga * h;
+    if (curv <= 0.0) {
+        return std::nan("");
+    }
+    return a - 0.5 * ga * h * h / curv;
+}
+
+// Clamp t into [lo + margin (hi - lo), hi - margin (hi - lo)] for lo, hi in
+// either order; NaN falls back to the midpoint
+double safeguard(double t, double lo, double hi, double margin)
+{
+    const double a = std::min(lo, hi);
+    const double b = std::max(lo, hi);
+    if (!std::isfinite(t)) {
+        return 0.5 * (a + b);
+    }
+    return std::min(std::max(t, a + margin * (b - a)), b - margin * (b - a));
+}
+
+} // namespace
+
+LineSearcher::LineSearcher(LineSearch type)
+    : type_(type), c1_(1e-4), c2_(0.9), max_evals_(30), max_step_(1e10), trials_(1),
+      cache_(nullptr), manifold_(nullptr), stats_(nullptr), x_(nullptr), d_(nullptr),
+      t_(0.0), f_(0.0), has_gradient_(false), num_f_(0), num_g_(0)
+{
+}
+
+double LineSearcher::evaluate(double t)
+{
+    t_ = t;
+    has_gradient_ = false;
+    scale_into(t, *d_, step_);
+    {
+        ScopedTimer timer(stats_, PHASE_RETRACTION);
+        curve_->evaluate(t, point_);
+    }
+    f_ = cache_->objective(point_);
+    ++num_f_;
+    return f_;
+}
+
+double LineSearcher::speculate(double f0, double slope, double t0, double& t_prev, double& f_prev)
+{
+    const int k = std::min(trials_, max_evals_);
+    trial_points_.resize(k);
+    trial_ptrs_.resize(k);
+    {
+        ScopedTimer timer(stats_, PHASE_RETRACTION);
+        double t = t0;
+        for (int j = 0; j < k; ++j, t *= 0.5) {
+            curve_->evaluate(t, trial_points_[j]);
+            trial_ptrs_[j] = &trial_points_[j];
+        }
+    }
+    cache_->objective_batch(trial_ptrs_, trial_values_);
+    num_f_ += k;
+
+    int j = 0;
+    double t = t0;
+    while (j < k - 1 &&
+           !(std::isfinite(trial_values_[j]) && trial_values_[j] <= f0 + c1_ * t * slope)) {
+        ++j;
+        t *= 0.5;
+    }
+    if (j > 0) {
+        t_prev = 2.0 * t;
+        f_prev = trial_values_[j - 1];
+    }
+
+    t_ = t;
+    f_ = trial_values_[j];
+    has_gradient_ = false;
+    scale_into(t, *d_, step_);
+    std::swap(point_, trial_points_[j]);
+    cache_->store_objective(point_, f_);
+    return f_;
+}
+
+// phi'(t) = <grad f(y), T_{t d}(d)> with y = R_x(t d)
+double LineSearcher::derivative()
+{
+    gradient_ = cache_->riemannian_gradient(point_);
+    has_gradient_ = true;
+    ++num_g_;
+    {
+        ScopedTimer timer(stats_, PHASE_TRANSPORT);
+        manifold_->vector_transport_into(*x_, step_, point_, *d_, transported_);
+    }
+    return manifold_->metric(point_, gradient_, transported_);
+}
+
+bool LineSearcher::curvature_holds(double dphi, double slope, bool strong, double c2) const
+{
+    return strong ? std::abs(dphi) <= -c2 * slope : dphi >= c2 * slope;
+}
+
+bool LineSearcher::search(EvaluationCache& cache, const ManifoldPoint& x, const ManifoldVector& d,
+                          double f0, double slope, double t0)
+{
+    ScopedTimer timer(stats_, PHASE_LINE_SEARCH);
+    cache_ = &cache;
+    manifold_ = cache.manifold();
+    if (!manifold_) {
+        throw std::runtime_error("LineSearcher: the problem has no manifold");
+    }
+    if (!(slope < 0.0)) {
+        throw std::runtime_error("LineSearcher: d is not a descent direction");
+    }
+    x_ = &x;
+    d_ = &d;
+    {
+        ScopedTimer timer(stats_, PHASE_RETRACTION);
+        manifold_->retraction_curve_into(x, d, curve_);
+    }
+    num_f_ = 0;
+    num_g_ = 0;
+    t0 = std::min(t0, max_step_);
+
+    switch (type_) {
+        case LineSearch::LINESEARCH_ARMIJO:
+            return armijo(f0, slope, t0);
+        case LineSearch::LINESEARCH_WOLFE:
+            return wolfe(f0, slope, t0, false, c2_);
+        case LineSearch::LINESEARCH_STRONG_WOLFE:
+            return wolfe(f0, slope, t0, true, c2_);
+        case LineSearch::LINESEARCH_EXACT:
+            return wolfe(f0, slope, t0, true, std::min(c2_, 1e-2));
+    }
+    throw std::runtime_error("Unknown line search type");
+}
+
+bool LineSearcher::armijo(double f0, double slope, double t0)
+{
+    double t_prev = 0.0;
+    double f_prev = 0.0;
+    double f = trials_ > 1 ? speculate(f0, slope, t0, t_prev, f_prev) : evaluate(t0);
+    double t = t_;
+    while (!(std::isfinite(f) && f <= f0 + c1_ * t * slope)) {
+        if (num_f_ >= max_evals_) {
+            return false;
+        }
+        double t_new;
+        if (t_prev == 0.0 || !std::isfinite(f) || !std::isfinite(f_prev)) {
+            // Quadratic through phi(0), phi'(0) and phi(t)
+            t_new = std::isfinite(f) ? quadratic_minimizer(0.0, f0, slope, t, f) : std::nan("");
+        } else {
+            // Cubic through phi(0), phi'(0), phi(t_prev) and phi(t)
+            const double r1 = f - f0 - slope * t;
+            const double r2 = f_prev - f0 - slope * t_prev;
+            const double denom = t_prev * t_prev * t * t * (t - t_prev);
+            const double a = (t_prev * t_prev * r1 - t * t * r2) / denom;
+            const double b = (-t_prev * t_prev * t_prev * r1 + t * t * t * r2) / denom;
+            if (a == 0.0) {
+                t_new = -slope / (2.0 * b);
+            } else {
+                const double disc = b * b - 3.0 * a * slope;
+                t_new = disc >= 0.0 ? (-b + std::sqrt(disc)) / (3.0 * a) : std::nan("");
+            }
+        }
+        // Shrink by at least a factor 2 and at most 10
+        t_new = std::isfinite(t_new) ? std::min(std::max(t_new, 0.1 * t), 0.5 * t) : 0.5 * t;
+        t_prev = t;
+        f_prev = f;
+        t = t_new;
+        f = evaluate(t);
+    }
+    return true;
+}
+
+// Bracketing phase followed by zoom, Nocedal & Wright Algorithms 3.5 and 3.6
+bool LineSearcher::wolfe(double f0, double slope, double t0, bool strong, double c2)
+{
+    double t_prev = 0.0;
+    double f_prev = f0;
+    double g_prev = slope;
+    double t = t0;
+
+    double lo = 0.0, f_lo = f0, g_lo = slope;
+    double hi = 0.0, f_hi = 0.0, g_hi = 0.0;
+    bool g_hi_known = false;
+    bool bracketed = false;
+
+    // Bracketing
+    while (!bracketed) {
+        const double f = evaluate(t);
+        if (!std::isfinite(f) || f > f0 + c1_ * t * slope || (num_f_ > 1 && f >= f_prev)) {
+            lo = t_prev; f_lo = f_prev; g_lo = g_prev;
+            hi = t; f_hi = f; g_hi_known = false;
+            bracketed = true;
+            break;
+        }
+        const double g = derivative();
+        if (curvature_holds(g, slope, strong, c2)) {
+            return true;
+        }
+        if (g >= 0.0) {
+            lo = t; f_lo = f; g_lo = g;
+            hi = t_prev; f_hi = f_prev; g_hi = g_prev; g_hi_known = true;
+            bracketed = true;
+            break;
+        }
+        if (num_f_ >= max_evals_ || t >= max_step_) {
+            return false;
+        }
+        // Extrapolate by cubic interpolation, growing the step by 2 to 10
+        double t_next = cubic_minimizer(t_prev, f_prev, g_prev, t, f, g);
+        t_next = std::isfinite(t_next) ? std::min(std::max(t_next, 2.0 * t), 10.0 * t) : 2.0 * t;
+        t_prev = t;
+        f_prev = f;
+        g_prev = g;
+        t = std::min(t_next, max_step_);
+    }
+
+    // Zoom: [lo, hi] contains acceptable steps and lo satisfies sufficient
+    // decrease with the lowest value seen
+    while (num_f_ < max_evals_) {
+        double t_new = std::isfinite(f_hi) && g_hi_known
+                           ? cubic_minimizer(lo, f_lo, g_lo, hi, f_hi, g_hi)
+                           : std::isfinite(f_hi) ? quadratic_minimizer(lo, f_lo, g_lo, hi, f_hi)
+                                                 : std::nan("");
+        t_new = safeguard(t_new, lo, hi, 0.1);
+
+        const double f = evaluate(t_new);
+        if (!std::isfinite(f) || f > f0 + c1_ * t_new * slope || f >= f_lo) {
+            hi = t_new; f_hi = f; g_hi_known = false;
+            continue;
+        }
+        const double g = derivative();
+        if (curvature_holds(g, slope, strong, c2)) {
+            return true;
+        }
+        if (g * (hi - lo) >= 0.0) {
+            hi = lo; f_hi = f_lo; g_hi = g_lo; g_hi_known = true;
+        }
+        lo = t_new; f_lo = f; g_lo = g;
+        if (std::abs(hi - lo) <= 1e-14 * std::max(1.0, lo)) {
+            break;
+        }
+    }
+    return false;
+}
+
+} // namespace OptimLight
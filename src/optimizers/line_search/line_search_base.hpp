@@ -0,0 +1,123 @@
+#ifndef LINE_SEARCH_BASE_HPP
+#define LINE_SEARCH_BASE_HPP
+
+#include "../../evaluation_cache.hpp"
+#include "../../types.hpp"
+#include "../solver_stats.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace OptimLight
+{
+
+// Line search along the retraction curve t -> R_x(t d), shared by the
+// line-search solvers.
+//
+//   LINESEARCH_ARMIJO         backtracking on the sufficient decrease
+//                             condition, with quadratic then cubic
+//                             interpolation of phi(t) = f(R_x(t d))
+//   LINESEARCH_WOLFE          bracketing and zoom (cubic interpolation)
+//   LINESEARCH_STRONG_WOLFE   until the (strong) Wolfe conditions hold
+//   LINESEARCH_EXACT          strong Wolfe with a tight curvature
+//                             tolerance, an approximately exact minimizer
+//
+// The accepted step is always the last point evaluated, and its retraction
+// result, objective value and (for the Wolfe variants) Riemannian gradient
+// are kept, so the solver reads them back instead of evaluating the new
+// iterate again.
+class LineSearcher
+{
+public:
+    explicit LineSearcher(LineSearch type = LineSearch::LINESEARCH_ARMIJO);
+
+    void set_type(LineSearch type) { type_ = type; }
+    LineSearch type() const { return type_; }
+
+    // Sufficient decrease and curvature constants, 0 < c1 < c2 < 1
+    void set_constants(double c1, double c2) {
+        c1_ = c1;
+        c2_ = c2;
+    }
+    void set_max_evaluations(int max_evals) { max_evals_ = max_evals; }
+    void set_max_step(double max_step) { max_step_ = max_step; }
+    // Number of trial steps evaluated together in the first round of the
+    // Armijo search: t0, t0/2, ..., t0/2^(k-1) go to one batched objective
+    // call (Problem::objective_batch) and the longest that satisfies
+    // sufficient decrease is taken. Pays off when the problem batches its
+    // evaluations and t0 is often rejected. 1, the default, turns it off.
+    void set_speculative_trials(int trials) { trials_ = std::max(trials, 1); }
+    // Time the search, its retractions and transports into stats (null: off)
+    void set_stats(SolverStats* stats) { stats_ = stats; }
+
+    // Search from x along the tangent vector d, with f0 = f(x) and
+    // slope = <grad f(x), d> < 0, starting with step t0. Evaluations go
+    // through `cache`, which therefore holds the accepted point afterwards.
+    // Returns false if no acceptable step was found within the evaluation
+    // budget.
+    bool search(EvaluationCache& cache, const ManifoldPoint& x, const ManifoldVector& d,
+                double f0, double slope, double t0 = 1.0);
+
+    // The accepted step of the last successful search
+    double step() const { return t_; }
+    const ManifoldVector& step_vector() const { return step_; }   // t * d
+    const ManifoldPoint& point() const { return point_; }         // R_x(t d)
+    double value() const { return f_; }                           // f(R_x(t d))
+    bool has_gradient() const { return has_gradient_; }
+    const ManifoldVector& gradient() const { return gradient_; }  // grad f(R_x(t d))
+
+    // Objective and gradient evaluations of the last search
+    int function_evaluations() const { return num_f_; }
+    int gradient_evaluations() const { return num_g_; }
+
+private:
+    LineSearch type_;
+    double c1_;
+    double c2_;
+    int max_evals_;
+    double max_step_;
+    int trials_;
+
+    EvaluationCache* cache_;
+    const Manifold* manifold_;
+    SolverStats* stats_;
+    const ManifoldPoint* x_;
+    const ManifoldVector* d_;
+    // t -> R_x(t d), bound once per search so that the trial steps share
+    // the factorisations of the retraction, and kept across searches so
+    // that binding reuses its storage
+    std::unique_ptr<RetractionCurve> curve_;
+
+    // Last evaluated point
+    double t_;
+    double f_;
+    bool has_gradient_;
+    ManifoldVector step_;
+    ManifoldPoint point_;
+    ManifoldVector gradient_;
+    ManifoldVector transported_;
+
+    // Speculative trials, reused across searches
+    std::vector<ManifoldPoint> trial_points_;
+    std::vector<const ManifoldPoint*> trial_ptrs_;
+    std::vector<double> trial_values_;
+
+    int num_f_;
+    int num_g_;
+
+    // phi(t), moving the last evaluated point to t
+    double evaluate(double t);
+    // phi at the speculative trials, moving to the longest acceptable one
+    // (or the shortest); t_prev and f_prev receive the trial before it
+    double speculate(double f0, double slope, double t0, double& t_prev, double& f_prev);
+    // phi'(t) at the last evaluated point
+    double derivative();
+
+    bool armijo(double f0, double slope, double t0);
+    bool wolfe(double f0, double slope, double t0, bool strong, double c2);
+    bool curvature_holds(double dphi, double slope, bool strong, double c2) const;
+};
+
+} // namespace OptimLight
+
+#endif // LINE_SEARCH_BASE_HPP
@@ -0,0 +1,113 @@
+#include "solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+const int Solver::history_length;
+
+Solver::Solver(const Problem* problem)
+    : problem_(problem), manifold_(nullptr), cache_(problem),
+      f_(0.0), gnorm_(0.0), iter_(0), verbose_(Verbose::VERBOSE_LOW),
+      max_iter_(1000), gtol_(1e-6), ftol_rel_(1e-12), max_time_(0.0),
+      timing_(true), history_count_(0)
+{
+}
+
+double Solver::predicted_iteration_time() const
+{
+    const int n = std::min(history_count_, history_length);
+    if (n == 0) {
+        return 0.0;
+    }
+    // The larger of the last iteration and the recent mean, so that one
+    // cheap iteration after expensive ones does not hide the trend
+    const double last = history_[(history_count_ - 1) % history_length];
+    double mean = 0.0;
+    for (int i = 0; i < n; ++i) {
+        mean += history_[i];
+    }
+    mean /= n;
+    return std::max(last, mean);
+}
+
+Result Solver::minimize(ManifoldPoint& x)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t_start = Clock::now();
+    auto elapsed = [&t_start]() {
+        return std::chrono::duration<double>(Clock::now() - t_start).count();
+    };
+
+    manifold_ = problem_->get_manifold();
+    if (!manifold_) {
+        throw std::runtime_error(std::string(name()) + ": the problem has no manifold");
+    }
+
+    stats_.reset();
+    cache_.set_stats(timers());
+    cache_.clear();
+    history_count_ = 0;
+
+    iter_ = 0;
+    // f and the Euclidean gradient come from one fused evaluation, unless
+    // the problem supplies its Riemannian gradient itself
+    f_ = problem_->has_riemannian_gradient() ? cache_.objective(x)
+                                             : cache_.objective_and_gradient(x);
+    grad_ = cache_.riemannian_gradient(x);
+    gnorm_ = cache_.riemannian_gradient_norm(x);
+    start(x);
+
+    Result result = Result::RESULT_DIDNOTRUN;
+    while (result == Result::RESULT_DIDNOTRUN) {
+        if (!std::isfinite(f_) || !std::isfinite(gnorm_)) {
+            result = Result::RESULT_INFINITE;
+            break;
+        }
+        if (gnorm_ <= gtol_) {
+            result = Result::RESULT_GTOL_REACHED;
+            break;
+        }
+        if (iter_ >= max_iter_) {
+            result = Result::RESULT_MAXITER_REACHED;
+            break;
+        }
+        const double t_iter = elapsed();
+        if (max_time_ > 0.0 && t_iter + predicted_iteration_time() > max_time_) {
+            result = Result::RESULT_MAXTIME_REACHED;
+            break;
+        }
+
+        const double f_old = f_;
+        Result stop = Result::RESULT_DIDNOTRUN;
+        const bool moved = iterate(x, stop);
+        ++iter_;
+        history_[history_count_++ % history_length] = elapsed() - t_iter;
+
+        if (verbose_ != Verbose::VERBOSE_LOW) {
+            std::cout << name() << " iter " << iter_ << (moved ? "" : " (rejected)")
+                      << ": f = " << f_ << ", |grad| = " << gnorm_ << std::endl;
+        }
+        if (stop != Result::RESULT_DIDNOTRUN) {
+            result = stop;
+        } else if (monitor_ && !monitor_(iter_, f_, gnorm_)) {
+            result = Result::RESULT_STOPPED;
+        } else if (moved && std::abs(f_old - f_) <= ftol_rel_ * std::max(std::abs(f_old), 1.0)) {
+            result = Result::RESULT_FTOLREL_REACHED;
+        }
+    }
+
+    stats_.iterations = iter_;
+    stats_.total_seconds = elapsed();
+    cache_.set_stats(nullptr);
+    if (verbose_ == Verbose::VERBOSE_COMPLETE) {
+        std::cout << name() << ": " << stats_.report();
+    }
+    return result;
+}
+
+} // namespace OptimLight
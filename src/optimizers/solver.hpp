@@ -0,0 +1,92 @@
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include "../evaluation_cache.hpp"
+#include "../types.hpp"
+#include "solver_stats.hpp"
+#include <functional>
+#include <utility>
+
+namespace OptimLight
+{
+
+// Common driver of the iterative solvers. minimize() owns the outer loop
+// and the stopping tests (gradient norm, relative decrease, iteration and
+// time limits, non-finite values) and records per-phase timings; the
+// solvers implement a single iteration.
+//
+// With a time limit the loop predicts the cost of the next iteration from
+// the last few and returns RESULT_MAXTIME_REACHED before starting one that
+// would not finish within the budget.
+class Solver
+{
+public:
+    explicit Solver(const Problem* problem);
+    virtual ~Solver() = default;
+
+    // Minimize starting from x, which is overwritten with the last iterate
+    Result minimize(ManifoldPoint& x);
+
+    // Stopping criteria. max_time is in seconds, <= 0 for no limit.
+    void set_max_iter(int max_iter) { max_iter_ = max_iter; }
+    void set_gtol(double gtol) { gtol_ = gtol; }
+    void set_ftol_rel(double ftol_rel) { ftol_rel_ = ftol_rel; }
+    void set_max_time(double max_time) { max_time_ = max_time; }
+    void set_verbose(Verbose verbose) { verbose_ = verbose; }
+    // Per-phase timers, on by default
+    void set_timing(bool timing) { timing_ = timing; }
+
+    // Called after every iteration with the iteration count, f and the
+    // gradient norm of the iterate. Returning false ends the run with
+    // RESULT_STOPPED. Empty (never stop) by default.
+    typedef std::function<bool(int iter, double f, double gnorm)> Monitor;
+    void set_monitor(Monitor monitor) { monitor_ = std::move(monitor); }
+
+    // State of the last run
+    int iterations() const { return iter_; }
+    double f_value() const { return f_; }
+    double gradient_norm() const { return gnorm_; }
+    const SolverStats& stats() const { return stats_; }
+
+protected:
+    // Prepare a run from x; f_, grad_ and gnorm_ are already set
+    virtual void start(const ManifoldPoint& x) = 0;
+
+    // One iteration from x. On return f_, grad_ and gnorm_ describe x and
+    // the return value says whether x moved. Set `stop` to end the run.
+    virtual bool iterate(ManifoldPoint& x, Result& stop) = 0;
+
+    virtual const char* name() const = 0;
+
+    // Stats sink for the solver's own timers, null when timing is off
+    SolverStats* timers() { return timing_ ? &stats_ : nullptr; }
+
+    const Problem* problem_;
+    const Manifold* manifold_;
+    EvaluationCache cache_;   // Iterate and trial point
+    ManifoldVector grad_;     // Riemannian gradient at the iterate
+    double f_;
+    double gnorm_;
+    int iter_;
+    Verbose verbose_;
+
+private:
+    int max_iter_;
+    double gtol_;
+    double ftol_rel_;
+    double max_time_;
+    bool timing_;
+    Monitor monitor_;
+    SolverStats stats_;
+
+    // Durations of the last iterations, for the time budget prediction
+    static const int history_length = 5;
+    double history_[history_length];
+    int history_count_;
+
+    double predicted_iteration_time() const;
+};
+
+} // namespace OptimLight
+
+#endif // SOLVER_HPP
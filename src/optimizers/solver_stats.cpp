@@ -0,0 +1,36 @@
+#include "solver_stats.hpp"
+#include <cstdio>
+
+namespace OptimLight
+{
+
+const char* phase_to_string(Phase phase)
+{
+    switch (phase) {
+        case PHASE_OBJECTIVE: return "objective";
+        case PHASE_GRADIENT: return "gradient";
+        case PHASE_OBJECTIVE_AND_GRADIENT: return "obj+gradient";
+        case PHASE_HESSIAN: return "hessian";
+        case PHASE_RETRACTION: return "retraction";
+        case PHASE_TRANSPORT: return "transport";
+        case PHASE_LINE_SEARCH: return "line search";
+        default: return "";
+    }
+}
+
+std::string SolverStats::report() const
+{
+    std::string out;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%d iterations in %.6f s\n", iterations, total_seconds);
+    out += line;
+    for (int i = 0; i < PhaseLength; ++i) {
+        const double share = total_seconds > 0.0 ? 100.0 * seconds[i] / total_seconds : 0.0;
+        std::snprintf(line, sizeof(line), "  %-12s %12.6f s %6.1f %% %10ld calls\n",
+                      phase_to_string(static_cast<Phase>(i)), seconds[i], share, calls[i]);
+        out += line;
+    }
+    return out;
+}
+
+} // namespace OptimLight
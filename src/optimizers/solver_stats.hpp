@@ -0,0 +1,82 @@
+#ifndef SOLVER_STATS_HPP
+#define SOLVER_STATS_HPP
+
+#include <chrono>
+#include <string>
+
+namespace OptimLight
+{
+
+// Phases a solve spends its time in. The line search phase includes the
+// objective, gradient, retraction and transport calls made inside it. A
+// fused evaluation of f and its gradient, Problem::evaluate_obj_and_grad,
+// cannot be split between the two, so it has a phase of its own; the
+// objective and gradient phases only count separate evaluations.
+enum Phase {
+    PHASE_OBJECTIVE,
+    PHASE_GRADIENT,
+    PHASE_OBJECTIVE_AND_GRADIENT,
+    PHASE_HESSIAN,
+    PHASE_RETRACTION,
+    PHASE_TRANSPORT,
+    PHASE_LINE_SEARCH,
+    PhaseLength
+};
+
+const char* phase_to_string(Phase phase);
+
+// Wall-clock time and call count per phase for one solve. Filled through
+// ScopedTimer, which costs two steady_clock reads per timed call.
+struct SolverStats
+{
+    SolverStats() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < PhaseLength; ++i) {
+            seconds[i] = 0.0;
+            calls[i] = 0;
+        }
+        iterations = 0;
+        total_seconds = 0.0;
+    }
+
+    // One line per phase with its time, share of the total and call count
+    std::string report() const;
+
+    double seconds[PhaseLength];
+    long calls[PhaseLength];
+    int iterations;
+    double total_seconds;
+};
+
+// Adds the lifetime of the object to `phase` of `stats`; a null stats
+// pointer disables timing.
+class ScopedTimer
+{
+public:
+    ScopedTimer(SolverStats* stats, Phase phase) : stats_(stats), phase_(phase) {
+        if (stats_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (stats_) {
+            stats_->seconds[phase_] +=
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+            ++stats_->calls[phase_];
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    SolverStats* stats_;
+    Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace OptimLight
+
+#endif // SOLVER_STATS_HPP
@@ -0,0 +1,118 @@
+#include "trust_region.hpp"
+#include "../vector_ops.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace OptimLight
+{
+
+TrustRegion::TrustRegion(const Problem* problem)
+    : Solver(problem),
+      Delta_bar_(0.0), Delta0_(0.0), rho_prime_(0.1),
+      kappa_(0.1), theta_(1.0), max_inner_(0),
+      total_inner_(0), Delta_(0.0), Delta_max_(0.0)
+{
+}
+
+bool TrustRegion::truncated_cg(const ManifoldPoint& x)
+{
+    const double Delta2 = Delta_ * Delta_;
+    const int max_inner = max_inner_ > 0 ? max_inner_ : manifold_->dimension();
+
+    scale_into(0.0, grad_, eta_);
+    scale_into(0.0, grad_, Heta_);
+    r_ = grad_;
+    z_ = problem_->conditioner(x, r_);
+    scale_into(-1.0, z_, delta_);
+
+    // Norms of eta and delta in the preconditioner's metric, updated by
+    // recurrences so that the boundary test needs no extra inner products
+    double e_Pe = 0.0;
+    double e_Pd = 0.0;
+    double z_r = manifold_->metric(x, z_, r_);
+    double d_Pd = z_r;
+    const double norm_r0 = std::sqrt(manifold_->metric(x, r_, r_));
+    const double target = norm_r0 * std::min(std::pow(norm_r0, theta_), kappa_);
+
+    for (int j = 0; j < max_inner; ++j) {
+        ++total_inner_;
+        cache_.hessian_vector(x, delta_, Hdelta_);
+        const double d_Hd = manifold_->metric(x, delta_, Hdelta_);
+        const double alpha = z_r / d_Hd;
+        const double e_Pe_new = e_Pe + 2.0 * alpha * e_Pd + alpha * alpha * d_Pd;
+
+        if (d_Hd <= 0.0 || e_Pe_new >= Delta2) {
+            // Negative curvature or leaving the region: go to the boundary
+            const double tau = (-e_Pd + std::sqrt(e_Pd * e_Pd + d_Pd * (Delta2 - e_Pe))) / d_Pd;
+            axpy(tau, delta_, eta_);
+            axpy(tau, Hdelta_, Heta_);
+            return true;
+        }
+
+        axpy(alpha, delta_, eta_);
+        axpy(alpha, Hdelta_, Heta_);
+        e_Pe = e_Pe_new;
+
+        axpy(alpha, Hdelta_, r_);
+        if (std::sqrt(manifold_->metric(x, r_, r_)) <= target) {
+            return false;
+        }
+
+        z_ = problem_->conditioner(x, r_);
+        const double z_r_old = z_r;
+        z_r = manifold_->metric(x, z_, r_);
+        const double beta = z_r / z_r_old;
+        axpby(-1.0, z_, beta, delta_);
+
+        e_Pd = beta * (e_Pd + alpha * d_Pd);
+        d_Pd = z_r + beta * beta * d_Pd;
+    }
+    return false;
+}
+
+void TrustRegion::start(const ManifoldPoint&)
+{
+    Delta_max_ = Delta_bar_ > 0.0 ? Delta_bar_
+                                  : std::sqrt(static_cast<double>(manifold_->dimension()));
+    Delta_ = Delta0_ > 0.0 ? Delta0_ : Delta_max_ / 8.0;
+    total_inner_ = 0;
+}
+
+bool TrustRegion::iterate(ManifoldPoint& x, Result& stop)
+{
+    const bool at_boundary = truncated_cg(x);
+
+    {
+        ScopedTimer timer(timers(), PHASE_RETRACTION);
+        manifold_->retraction_into(x, eta_, x_trial_);
+    }
+    const double f_trial = cache_.objective(x_trial_);
+    const double predicted = -(manifold_->metric(x, grad_, eta_) +
+                               0.5 * manifold_->metric(x, eta_, Heta_));
+    const double rho = predicted > 0.0 ? (f_ - f_trial) / predicted
+                                       : -std::numeric_limits<double>::infinity();
+
+    if (rho < 0.25) {
+        Delta_ *= 0.25;
+    } else if (rho > 0.75 && at_boundary) {
+        Delta_ = std::min(2.0 * Delta_, Delta_max_);
+    }
+
+    if (!(rho > rho_prime_ && std::isfinite(f_trial))) {
+        if (Delta_ < std::numeric_limits<double>::epsilon() * Delta_max_) {
+            // The model can no longer predict any decrease
+            stop = Result::RESULT_FTOL_REACHED;
+        }
+        return false;
+    }
+
+    x = x_trial_;
+    f_ = f_trial;
+    grad_ = cache_.riemannian_gradient(x);
+    gnorm_ = cache_.riemannian_gradient_norm(x);
+    return true;
+}
+
+} // namespace OptimLight
@@ -0,0 +1,78 @@
+#ifndef TRUST_REGION_HPP
+#define TRUST_REGION_HPP
+
+#include "../solver.hpp"
+
+namespace OptimLight
+{
+
+// Riemannian trust-region method.
+//
+// Each outer iteration approximately minimizes the quadratic model
+//     m(eta) = f(x) + <grad f(x), eta> + 1/2 <eta, Hess f(x)[eta]>
+// over ||eta|| <= Delta with the Steihaug-Toint truncated conjugate gradient
+// method, preconditioned by Problem::conditioner. The Hessian is only used
+// through Hessian-vector products (analytic if the problem provides them,
+// finite differences of the gradient otherwise), so it is never formed.
+// With the default inner stopping rule (theta = 1) the local convergence is
+// quadratic.
+class TrustRegion : public Solver
+{
+public:
+    explicit TrustRegion(const Problem* problem);
+
+    // Radius control. Delta_bar <= 0 means sqrt(dimension of the manifold),
+    // Delta0 <= 0 means Delta_bar / 8.
+    void set_radius(double Delta_bar, double Delta0) {
+        Delta_bar_ = Delta_bar;
+        Delta0_ = Delta0;
+    }
+    // A step is accepted when the actual/predicted decrease ratio exceeds rho_prime
+    void set_rho_prime(double rho_prime) { rho_prime_ = rho_prime; }
+
+    // Inner tCG: stop when |r| <= |r0| min(|r0|^theta, kappa), or after
+    // max_inner iterations (<= 0 means the manifold dimension)
+    void set_inner(double kappa, double theta, int max_inner) {
+        kappa_ = kappa;
+        theta_ = theta;
+        max_inner_ = max_inner;
+    }
+
+    // State of the last run
+    int inner_iterations() const { return total_inner_; }
+    double radius() const { return Delta_; }
+
+protected:
+    void start(const ManifoldPoint& x) override;
+    bool iterate(ManifoldPoint& x, Result& stop) override;
+    const char* name() const override { return "TR"; }
+
+private:
+    double Delta_bar_;
+    double Delta0_;
+    double rho_prime_;
+    double kappa_;
+    double theta_;
+    int max_inner_;
+
+    // Work vectors, reused across iterations
+    ManifoldPoint x_trial_;
+    ManifoldVector eta_;
+    ManifoldVector Heta_;
+    ManifoldVector r_;
+    ManifoldVector z_;
+    ManifoldVector delta_;
+    ManifoldVector Hdelta_;
+
+    int total_inner_;
+    double Delta_;
+    double Delta_max_;  // Delta_bar_ resolved for the current run
+
+    // Steihaug-Toint tCG for the model at x; leaves the step in eta_ and
+    // Hess[eta] in Heta_. Returns true if the step reached the boundary.
+    bool truncated_cg(const ManifoldPoint& x);
+};
+
+} // namespace OptimLight
+
+#endif // TRUST_REGION_HPP
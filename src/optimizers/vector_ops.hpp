@@ -0,0 +1,59 @@
+#ifndef VECTOR_OPS_HPP
+#define VECTOR_OPS_HPP
+
+#include "../manifolds/manifold.hpp"
+
+namespace OptimLight
+{
+
+// In-place tangent vector updates shared by the solvers. They work on the
+// backend storage directly, so unlike the Array operators they create no
+// temporaries.
+
+// y += a * x
+inline void axpy(double a, const ManifoldVector& x, ManifoldVector& y)
+{
+    if (y.is_complex()) {
+        y.as_cx_mat() += a * x.as_cx_mat();
+    } else {
+        y.as_mat() += a * x.as_mat();
+    }
+}
+
+// y = a * x, reusing the storage of y
+inline void scale_into(double a, const ManifoldVector& x, ManifoldVector& y)
+{
+    y.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    if (x.is_complex()) {
+        y.as_cx_mat() = a * x.as_cx_mat();
+    } else {
+        y.as_mat() = a * x.as_mat();
+    }
+}
+
+// out = a * x + b * y in one pass, reusing the storage of out. x and y
+// must have the same size and type; out may alias either of them.
+inline void lincomb(double a, const ManifoldVector& x, double b, const ManifoldVector& y,
+                    ManifoldVector& out)
+{
+    if (y.n_rows() != x.n_rows() || y.n_cols() != x.n_cols() ||
+        y.is_complex() != x.is_complex()) {
+        throw std::runtime_error("lincomb: operands differ in size or type");
+    }
+    out.set_size(x.n_rows(), x.n_cols(), x.is_complex());
+    if (x.is_complex()) {
+        out.as_cx_mat() = a * x.as_cx_mat() + b * y.as_cx_mat();
+    } else {
+        out.as_mat() = a * x.as_mat() + b * y.as_mat();
+    }
+}
+
+// y = a * x + b * y
+inline void axpby(double a, const ManifoldVector& x, double b, ManifoldVector& y)
+{
+    lincomb(a, x, b, y, y);
+}
+
+} // namespace OptimLight
+
+#endif // VECTOR_OPS_HPP
@@ -1,4 +1,7 @@
 #include "problem.hpp"
+#include "optimizers/vector_ops.hpp"
+#include <cmath>
+#include <stdexcept>
 
 namespace OptimLight
 {
@@ -15,14 +18,151 @@ ManifoldVector Problem::gradient(const ManifoldPoint &x) const
     return ManifoldVector();
 }
 
-void Problem::evaluate_obj_and_grad(const ManifoldPoint &x) const
+void Problem::objective_batch(const std::vector<const ManifoldPoint*> &xs,
+                              std::vector<double> &values) const
 {
-    // Provide a default implementation or leave it pure virtual
+    values.resize(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        values[i] = objective_function(*xs[i]);
+    }
+}
+
+void Problem::gradient_batch(const std::vector<const ManifoldPoint*> &xs,
+                             const std::vector<ManifoldVector*> &grads) const
+{
+    if (grads.size() != xs.size()) {
+        throw std::runtime_error("gradient_batch: one output per point expected");
+    }
+    for (size_t i = 0; i < xs.size(); ++i) {
+        *grads[i] = gradient(*xs[i]);
+    }
+}
+
+void Problem::evaluate_obj_and_grad(const ManifoldPoint &x, EvaluationContext &ctx) const
+{
+    if (!ctx.has_f) {
+        ctx.f = evaluate_objective(x, ctx);
+        ctx.has_f = true;
+    }
+    if (!ctx.has_egrad) {
+        evaluate_gradient(x, ctx, ctx.egrad);
+        ctx.has_egrad = true;
+    }
+}
+
+double Problem::evaluate_objective(const ManifoldPoint &x, EvaluationContext &) const
+{
+    return objective_function(x);
+}
+
+void Problem::evaluate_gradient(const ManifoldPoint &x, EvaluationContext &,
+                                ManifoldVector &egrad) const
+{
+    egrad = gradient(x);
+}
+
+void Problem::evaluate_riemannian_gradient(const ManifoldPoint &x, EvaluationContext &,
+                                           ManifoldVector &rgrad) const
+{
+    rgrad = riemannian_gradient(x);
 }
 
 ManifoldVector Problem::riemannian_gradient(const ManifoldPoint &x) const
 {
-    // Provide a default implementation or leave it pure virtual
-    return ManifoldVector();
+    if (!manifold_) {
+        throw std::runtime_error("riemannian_gradient: the problem has no manifold");
+    }
+    ManifoldVector rgrad;
+    manifold_->egrad_to_rgrad(x, gradient(x), rgrad);
+    return rgrad;
+}
+
+ManifoldVector Problem::euclidean_hessian_vector(const ManifoldPoint &,
+                                                 const ManifoldVector &) const
+{
+    throw std::runtime_error("euclidean_hessian_vector: not provided by this problem");
+}
+
+ManifoldVector Problem::hessian_vector(const ManifoldPoint &x, const ManifoldVector &eta) const
+{
+    ManifoldVector out;
+    finite_difference_hessian(x, riemannian_gradient(x), eta, out);
+    return out;
+}
+
+void Problem::finite_difference_hessian(const ManifoldPoint &x, const ManifoldVector &grad_x,
+                                        const ManifoldVector &eta, ManifoldVector &out,
+                                        FiniteDifferenceWorkspace *work) const
+{
+    FiniteDifferenceWorkspace local;
+    FiniteDifferenceWorkspace &w = work ? *work : local;
+    w.etas.assign(1, &eta);
+    w.outs.assign(1, &out);
+    finite_difference_hessian_batch(x, grad_x, w.etas, w.outs, &w);
+}
+
+void Problem::finite_difference_hessian_batch(const ManifoldPoint &x, const ManifoldVector &grad_x,
+                                              const std::vector<const ManifoldVector*> &etas,
+                                              const std::vector<ManifoldVector*> &outs,
+                                              FiniteDifferenceWorkspace *work) const
+{
+    if (!manifold_) {
+        throw std::runtime_error("finite_difference_hessian: the problem has no manifold");
+    }
+    if (outs.size() != etas.size()) {
+        throw std::runtime_error("finite_difference_hessian: one output per direction expected");
+    }
+    FiniteDifferenceWorkspace local;
+    FiniteDifferenceWorkspace &w = work ? *work : local;
+    const size_t k = etas.size();
+    // Growing keeps the buffers already there, and clear() keeps capacity
+    w.h.assign(k, 0.0);
+    if (w.steps.size() < k) {
+        w.steps.resize(k);
+        w.ys.resize(k);
+    }
+    w.displaced.clear();
+    for (size_t i = 0; i < k; ++i) {
+        const double norm_eta = std::sqrt(manifold_->metric(x, *etas[i], *etas[i]));
+        if (norm_eta == 0.0) {
+            continue;
+        }
+        w.h[i] = std::ldexp(1.0, -14) / norm_eta;
+        scale_into(w.h[i], *etas[i], w.steps[i]);
+        manifold_->retraction_into(x, w.steps[i], w.ys[i]);
+        w.displaced.push_back(&w.ys[i]);
+    }
+
+    // Riemannian gradients at the displaced points, into the outputs
+    w.grads.clear();
+    for (size_t i = 0; i < k; ++i) {
+        if (w.h[i] != 0.0) {
+            w.grads.push_back(outs[i]);
+        }
+    }
+    if (has_riemannian_gradient()) {
+        for (size_t j = 0; j < w.displaced.size(); ++j) {
+            *w.grads[j] = riemannian_gradient(*w.displaced[j]);
+        }
+    } else {
+        gradient_batch(w.displaced, w.grads);
+        for (size_t j = 0; j < w.displaced.size(); ++j) {
+            manifold_->egrad_to_rgrad(*w.displaced[j], *w.grads[j], *w.grads[j]);
+        }
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+        if (w.h[i] == 0.0) {
+            *outs[i] = *etas[i];
+            continue;
+        }
+        // The transported step, reversed, is the tangent vector at y that
+        // leads back to x to first order; transport the gradient at y along it
+        manifold_->vector_transport_into(x, w.steps[i], w.ys[i], w.steps[i], w.back);
+        w.back *= -1.0;
+        manifold_->vector_transport_into(w.ys[i], w.back, x, *outs[i], *outs[i]);
+        axpby(-1.0 / w.h[i], grad_x, 1.0 / w.h[i], *outs[i]);
+    }
+}
+
 }
-}
\ No newline at end of file
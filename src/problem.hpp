@@ -2,12 +2,34 @@
 #define PROBLEM_HPP
 
 #include "manifolds/manifold.hpp"
+#include "evaluation_context.hpp"
+#include <vector>
 
 namespace OptimLight
 {
+// Buffers of Problem::finite_difference_hessian_batch, sized on first use
+// and reused by later calls, so that repeated Hessian-vector products do
+// not reallocate their n x p temporaries. Owned by the caller, such as
+// EvaluationCache, rather than by the Problem, whose const operations may
+// run on several threads at once (see MultiStart).
+struct FiniteDifferenceWorkspace
+{
+        std::vector<double> h;
+        std::vector<ManifoldVector> steps;
+        std::vector<ManifoldPoint> ys;
+        std::vector<const ManifoldPoint*> displaced;
+        std::vector<ManifoldVector*> grads;
+        std::vector<const ManifoldVector*> etas;
+        std::vector<ManifoldVector*> outs;
+        ManifoldVector back;
+};
+
 class Problem
 {
 public:
+        Problem() : manifold_(nullptr) {}
+        virtual ~Problem() = default;
+
         // function value evaluated on x, which has to be defined for each problem
         // virtual double objective(const ManifoldPoint & x) = 0;
         virtual double objective_function(const ManifoldPoint & x)  const=0;
@@ -16,11 +38,41 @@ public:
         // virtual ManifoldPoint gradient(const ManifoldPoint& x) =0;
         virtual ManifoldVector  gradient(const ManifoldPoint & x) const=0;
 
-        // evaluate objective function and gradient at the same time.
-        virtual void evaluate_obj_and_grad(const ManifoldPoint & x) const=0 ;
+        // Objective values and Euclidean gradients of many points in one
+        // call, values[i] = f(*xs[i]) and *grads[i] = gradient(*xs[i]).
+        // Problems whose f is built from matrix products override them to
+        // stack the points and do one large product instead of one per
+        // point. The defaults loop over the points.
+        virtual void objective_batch(const std::vector<const ManifoldPoint*> & xs,
+                                     std::vector<double> & values) const;
+        virtual void gradient_batch(const std::vector<const ManifoldPoint*> & xs,
+                                    const std::vector<ManifoldVector*> & grads) const;
+
+        // evaluate objective function and gradient at the same time, storing
+        // both in ctx. The default calls the two hooks below for whatever ctx
+        // does not hold yet; override it when f and the gradient share work.
+        virtual void evaluate_obj_and_grad(const ManifoldPoint & x, EvaluationContext & ctx) const;
+
+        // Evaluation hooks used through EvaluationCache. ctx belongs to x and
+        // keeps intermediates stored by earlier calls at the same point, so
+        // overrides can reuse them. The defaults ignore ctx and call the
+        // plain functions.
+        virtual double evaluate_objective(const ManifoldPoint & x, EvaluationContext & ctx) const;
+        virtual void evaluate_gradient(const ManifoldPoint & x, EvaluationContext & ctx,
+                                       ManifoldVector & egrad) const;
+        virtual void evaluate_riemannian_gradient(const ManifoldPoint & x, EvaluationContext & ctx,
+                                                  ManifoldVector & rgrad) const;
 
-        // Riemannian Gradient defined on the manifold 
-        virtual ManifoldVector  riemannian_gradient(const ManifoldPoint & x ) const=0 ;
+        // Riemannian Gradient defined on the manifold. The default converts
+        // gradient(x) with Manifold::egrad_to_rgrad. Problems that override
+        // it override has_riemannian_gradient() as well.
+        virtual ManifoldVector  riemannian_gradient(const ManifoldPoint & x ) const;
+
+        // Whether riemannian_gradient is the problem's own. When it is not,
+        // EvaluationCache converts the cached Euclidean gradient itself,
+        // getting the gradient norm and the Hessian correction in the same
+        // pass instead of evaluating gradient(x) again.
+        virtual bool has_riemannian_gradient() const { return false; }
 
         // set the manifold of the objective function
         virtual void set_manifold(Manifold * mani_in) { manifold_ = mani_in; }
@@ -28,6 +80,42 @@ public:
         // get the manifold of the objective function
         inline Manifold * get_manifold() const { return manifold_; }  
 
+        // Riemannian Hessian of f at x applied to the tangent vector eta.
+        // Problems with an analytic Hessian override it together with
+        // has_hessian(); the default is finite_difference_hessian with the
+        // gradient at x evaluated on the spot.
+        virtual ManifoldVector hessian_vector(const ManifoldPoint & x,
+                                              const ManifoldVector & eta) const;
+        virtual bool has_hessian() const { return false; }
+
+        // Euclidean Hessian of f at x applied to eta. Problems that provide
+        // it override has_euclidean_hessian() as well; EvaluationCache then
+        // converts it with Manifold::ehess_to_rhess instead of differencing
+        // gradients. Ignored when has_hessian() is true.
+        virtual ManifoldVector euclidean_hessian_vector(const ManifoldPoint & x,
+                                                        const ManifoldVector & eta) const;
+        virtual bool has_euclidean_hessian() const { return false; }
+
+        // (T^{-1} grad f(R_x(h eta)) - grad f(x)) / h with h = 2^-14 / |eta|,
+        // where grad_x is the Riemannian gradient at x and T^{-1} is the
+        // vector transport from y = R_x(h eta) back to x. Costs one gradient
+        // evaluation, at y. It tends to the Riemannian Hessian when the
+        // transport suits the metric, as projection does the Euclidean
+        // metric on Stiefel; with the canonical metric it agrees only at
+        // critical points. The temporaries live in `work` when given, else
+        // in a workspace local to the call.
+        void finite_difference_hessian(const ManifoldPoint & x, const ManifoldVector & grad_x,
+                                       const ManifoldVector & eta, ManifoldVector & out,
+                                       FiniteDifferenceWorkspace * work = nullptr) const;
+
+        // The same for several directions, *outs[i] for *etas[i]. The
+        // gradients at the displaced points come from one gradient_batch
+        // call unless the problem has its own Riemannian gradient.
+        void finite_difference_hessian_batch(const ManifoldPoint & x, const ManifoldVector & grad_x,
+                                             const std::vector<const ManifoldVector*> & etas,
+                                             const std::vector<ManifoldVector*> & outs,
+                                             FiniteDifferenceWorkspace * work = nullptr) const;
+
         virtual ManifoldVector conditioner(const ManifoldPoint & x, 
                                         const ManifoldVector & eta) const 
         {
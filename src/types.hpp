@@ -23,6 +23,7 @@ enum class Result{
     RESULT_MAXTIME_REACHED = -2, //Expected to reach maximum allowed time in next iteration
     RESULT_EXCEEDED_BOUNDARY = -3, // Exceeded specified boundaries 
     RESULT_INFINITE = -4, // Encountered non-finite fval/grad/hess
+    RESULT_STOPPED = -5, // Stopped by the solver's monitor
     
     RESULT_SUCCESS = 1, // Success
     RESULT_FTOL_REACHED = 2, // Converged according to fval difference
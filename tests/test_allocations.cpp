@@ -0,0 +1,236 @@
+// The *_into operations reuse their output buffer and the per-thread memory
+// pool, so once both are warm they must not touch the heap, and neither
+// must an L-BFGS iteration built on them.
+//
+// Stiefel uses RT_POLAR_NS: the other retractions call a QR, eigen or LU
+// factorisation or a matrix exponential of the backend, which allocates
+// its own workspace on every call (see Stiefel::retraction_into).
+#include "alloc_counter.hpp"
+#include "evaluation_cache.hpp"
+#include "evaluation_context.hpp"
+#include "manifolds/euclidean.hpp"
+#include "manifolds/product_manifold.hpp"
+#include "manifolds/stacked_manifold.hpp"
+#include "manifolds/stiefel.hpp"
+#include "optimizers/line_search/lbfgs.hpp"
+#include "problem.hpp"
+#include "test_helpers.hpp"
+#include <gtest/gtest.h>
+#include <functional>
+#include <vector>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// Heap allocations of `calls` calls of f, after a few warm-up calls
+long allocations_after_warmup(const std::function<void()>& f, int calls = 10) {
+    for (int i = 0; i < 3; ++i) {
+        f();
+    }
+    const long before = alloc_count();
+    for (int i = 0; i < calls; ++i) {
+        f();
+    }
+    return alloc_count() - before;
+}
+
+void expect_allocation_free(const Manifold& M, const ManifoldPoint& x) {
+    ManifoldVector eta = M.projection(x, ManifoldVector(la::mat(
+        0.1 * la::randn(M.empty.n_rows(), M.empty.n_cols()))));
+    ManifoldVector xi = M.projection(x, ManifoldVector(la::mat(
+        la::randn(M.empty.n_rows(), M.empty.n_cols()))));
+    ManifoldPoint y = M.retraction(x, eta);
+    ManifoldVector out;
+    ManifoldPoint z;
+
+    EXPECT_EQ(allocations_after_warmup([&] { M.projection_into(x, xi, out); }), 0)
+        << M.name << " projection_into";
+    EXPECT_EQ(allocations_after_warmup([&] { M.retraction_into(x, eta, z); }), 0)
+        << M.name << " retraction_into";
+    EXPECT_EQ(allocations_after_warmup([&] { M.vector_transport_into(x, eta, y, xi, out); }), 0)
+        << M.name << " vector_transport_into";
+    double value = 0.0;
+    EXPECT_EQ(allocations_after_warmup([&] { value += M.metric(x, xi, xi); }), 0)
+        << M.name << " metric";
+    EXPECT_EQ(allocations_after_warmup([&] { value += M.egrad_to_rgrad(x, xi, out); }), 0)
+        << M.name << " egrad_to_rgrad";
+    EXPECT_GT(value, 0.0);
+}
+
+// Brockett cost tr(X^T A X N) with A = diag(a) and N = diag(p, ..., 1),
+// evaluated through the hooks by loops over the entries: a dense product
+// would let the backend allocate its blocking workspace, and the solver's
+// allocations are the ones to count. With factors > 1 it lives on the
+// product of that many copies of St(n, p), stacked by rows, and A is
+// diagonal on each block.
+class DiagonalBrockett : public Problem {
+public:
+    DiagonalBrockett(int n, int p, int factors = 1)
+        : stiefel_(n, p, CANONICAL, RT_POLAR_NS, VT_PROJECTION),
+          product_({&stiefel_}, {factors}), factors_(factors), a_(la::randn(n * factors, 1)) {
+        if (factors > 1) {
+            set_manifold(&product_);
+        } else {
+            set_manifold(&stiefel_);
+        }
+    }
+
+    double objective_function(const ManifoldPoint& x) const override {
+        const la::mat& X = x.as_mat();
+        double f = 0.0;
+        for (size_t j = 0; j < la::cols(X); ++j) {
+            for (size_t i = 0; i < la::rows(X); ++i) {
+                f += weight(j) * a_(i, 0) * X(i, j) * X(i, j);
+            }
+        }
+        return f;
+    }
+
+    ManifoldVector gradient(const ManifoldPoint& x) const override {
+        ManifoldVector egrad;
+        gradient_into(x, egrad);
+        return egrad;
+    }
+
+    double evaluate_objective(const ManifoldPoint& x, EvaluationContext&) const override {
+        return objective_function(x);
+    }
+
+    void evaluate_gradient(const ManifoldPoint& x, EvaluationContext&,
+                           ManifoldVector& egrad) const override {
+        gradient_into(x, egrad);
+    }
+
+    void gradient_batch(const std::vector<const ManifoldPoint*>& xs,
+                        const std::vector<ManifoldVector*>& grads) const override {
+        for (size_t i = 0; i < xs.size(); ++i) {
+            gradient_into(*xs[i], *grads[i]);
+        }
+    }
+
+    ManifoldPoint start() const {
+        ManifoldPoint x(stiefel_.n * factors_, stiefel_.p);
+        for (int k = 0; k < factors_; ++k) {
+            la::block(x.as_mat(), stiefel_.n * k, 0, stiefel_.n, stiefel_.p) =
+                stiefel_point<double>(stiefel_.n, stiefel_.p);
+        }
+        return x;
+    }
+
+private:
+    Stiefel<double> stiefel_;
+    ProductManifold product_;
+    int factors_;
+    la::mat a_;
+
+    double weight(size_t j) const { return static_cast<double>(stiefel_.p - j); }
+
+    void gradient_into(const ManifoldPoint& x, ManifoldVector& egrad) const {
+        const la::mat& X = x.as_mat();
+        egrad.set_size(la::rows(X), la::cols(X), false);
+        la::mat& G = egrad.as_mat();
+        for (size_t j = 0; j < la::cols(X); ++j) {
+            for (size_t i = 0; i < la::rows(X); ++i) {
+                G(i, j) = 2.0 * weight(j) * a_(i, 0) * X(i, j);
+            }
+        }
+    }
+};
+
+class AllocationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!alloc_counter_complete()) {
+            GTEST_SKIP() << "malloc is not interposed on this platform";
+        }
+        la::set_seed(42);
+    }
+};
+
+TEST_F(AllocationTest, Euclidean) {
+    Euclidean<double> E(50, 5);
+    expect_allocation_free(E, ManifoldPoint(la::mat(la::randn(50, 5))));
+}
+
+TEST_F(AllocationTest, Stiefel) {
+    for (int metric = 0; metric < MetricTypeLength; ++metric) {
+        Stiefel<double> S(50, 5, static_cast<MetricType>(metric), RT_POLAR_NS, VT_PROJECTION);
+        expect_allocation_free(S, ManifoldPoint(stiefel_point<double>(50, 5)));
+    }
+}
+
+TEST_F(AllocationTest, ProductManifold) {
+    Stiefel<double> S(50, 5, CANONICAL, RT_POLAR_NS, VT_PROJECTION);
+    Euclidean<double> E(20, 5);
+    ProductManifold P({&S, &E}, {2, 1});
+    ManifoldPoint x(120, 5);
+    la::block(x.as_mat(), 0, 0, 50, 5) = stiefel_point<double>(50, 5);
+    la::block(x.as_mat(), 50, 0, 50, 5) = stiefel_point<double>(50, 5);
+    la::block(x.as_mat(), 100, 0, 20, 5) = la::randn(20, 5);
+    expect_allocation_free(P, x);
+}
+
+TEST_F(AllocationTest, StackedManifold) {
+    Stiefel<double> S(50, 5, CANONICAL, RT_POLAR_NS, VT_PROJECTION);
+    StackedManifold M(&S, 4);
+    ManifoldPoint x(50, 20);
+    for (int i = 0; i < 4; ++i) {
+        la::block(x.as_mat(), 0, 5 * i, 50, 5) = stiefel_point<double>(50, 5);
+    }
+    expect_allocation_free(M, x);
+
+    // The metric sums over several chunks of copies without a buffer
+    Stiefel<double> small(6, 2);
+    StackedManifold many(&small, 150);
+    ManifoldPoint y(6, 300);
+    for (int i = 0; i < 150; ++i) {
+        la::block(y.as_mat(), 0, 2 * i, 6, 2) = stiefel_point<double>(6, 2);
+    }
+    const ManifoldVector eta = many.projection(y, ManifoldVector(la::mat(la::randn(6, 300))));
+    double value = 0.0;
+    EXPECT_EQ(allocations_after_warmup([&] { value += many.metric(y, eta, eta); }), 0)
+        << many.name << " metric";
+    EXPECT_GT(value, 0.0);
+}
+
+TEST_F(AllocationTest, FiniteDifferenceHessian) {
+    // The displaced point, step and transported vectors stay in the
+    // cache's workspace between products
+    DiagonalBrockett problem(50, 5);
+    const ManifoldPoint x = problem.start();
+    const ManifoldVector eta = problem.get_manifold()->projection(
+        x, ManifoldVector(la::mat(la::randn(50, 5))));
+    EvaluationCache cache(&problem);
+    ManifoldVector out;
+    EXPECT_EQ(allocations_after_warmup([&] { cache.hessian_vector(x, eta, out); }), 0);
+}
+
+TEST_F(AllocationTest, LBFGSIteration) {
+    // Nothing is allocated between two iterations once the work vectors,
+    // the cache and the line-search curve are warm, on Stiefel and on a
+    // product, whose batched transports take views of every vector
+    for (int factors : {1, 3}) {
+        DiagonalBrockett problem(200 / factors, 5, factors);
+        ManifoldPoint x = problem.start();
+        LBFGS solver(&problem);
+        solver.set_gtol(0.0);
+        solver.set_max_iter(40);
+        long at_10 = -1;
+        long at_30 = -1;
+        solver.set_monitor([&](int iter, double, double) {
+            if (iter == 10) {
+                at_10 = alloc_count();
+            } else if (iter == 30) {
+                at_30 = alloc_count();
+            }
+            return true;
+        });
+        solver.minimize(x);
+        ASSERT_GE(solver.iterations(), 30) << problem.get_manifold()->name;
+        EXPECT_EQ(at_30 - at_10, 0) << problem.get_manifold()->name;
+    }
+}
+
+} // namespace
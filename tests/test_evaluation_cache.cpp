@@ -0,0 +1,206 @@
+#include "test_helpers.hpp"
+#include "evaluation_cache.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// f = x^2 / 2, counting the calls the cache makes
+class CountingProblem : public ScalarProblem {
+public:
+    CountingProblem()
+        : ScalarProblem([](double x) { return 0.5 * x * x; },
+                        [](double x) { return x; },
+                        [](double) { return 1.0; }) {}
+
+    double objective_function(const ManifoldPoint& x) const override {
+        ++objectives;
+        return ScalarProblem::objective_function(x);
+    }
+
+    ManifoldVector gradient(const ManifoldPoint& x) const override {
+        ++gradients;
+        return ScalarProblem::gradient(x);
+    }
+
+    void objective_batch(const std::vector<const ManifoldPoint*>& xs,
+                         std::vector<double>& values) const override {
+        ++batches;
+        batch_points += static_cast<int>(xs.size());
+        values.resize(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            values[i] = ScalarProblem::objective_function(*xs[i]);
+        }
+    }
+
+    mutable int objectives = 0;
+    mutable int gradients = 0;
+    mutable int batches = 0;
+    mutable int batch_points = 0;
+};
+
+class EvaluationCacheTest : public ::testing::Test {
+protected:
+    EvaluationCacheTest()
+        : cache(&problem), a(ScalarProblem::scalar(1.0)), b(ScalarProblem::scalar(2.0)),
+          c(ScalarProblem::scalar(3.0)) {}
+
+    CountingProblem problem;
+    EvaluationCache cache;
+    ManifoldPoint a, b, c;
+};
+
+TEST_F(EvaluationCacheTest, SecondLookupIsAHit) {
+    EXPECT_EQ(cache.objective(a), 0.5);
+    EXPECT_EQ(cache.hits(), 0);
+    EXPECT_EQ(cache.evaluations(), 1);
+
+    EXPECT_EQ(cache.objective(a), 0.5);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.evaluations(), 1);
+    EXPECT_EQ(problem.objectives, 1);
+
+    // The gradient is a separate quantity: a miss, then a hit
+    EXPECT_EQ(cache.gradient(a).as_mat()(0, 0), 1.0);
+    EXPECT_EQ(cache.gradient(a).as_mat()(0, 0), 1.0);
+    EXPECT_EQ(cache.hits(), 2);
+    EXPECT_EQ(cache.evaluations(), 2);
+    EXPECT_EQ(problem.gradients, 1);
+}
+
+TEST_F(EvaluationCacheTest, RiemannianGradientReusesEuclideanGradient) {
+    EXPECT_EQ(cache.objective_and_gradient(a), 0.5);
+    EXPECT_EQ(problem.objectives, 1);
+    EXPECT_EQ(problem.gradients, 1);
+
+    EXPECT_EQ(cache.riemannian_gradient(a).as_mat()(0, 0), 1.0);
+    EXPECT_EQ(cache.riemannian_gradient_norm(a), 1.0);
+    EXPECT_EQ(cache.objective_and_gradient(a), 0.5);
+    EXPECT_EQ(problem.gradients, 1);
+    EXPECT_EQ(problem.objectives, 1);
+}
+
+TEST_F(EvaluationCacheTest, EvictsLeastRecentlyUsedPoint) {
+    // Capacity 2: touching a again makes b the oldest, so c replaces b
+    cache.objective(a);
+    cache.objective(b);
+    cache.objective(a);
+    cache.objective(c);
+    EXPECT_EQ(problem.objectives, 3);
+
+    cache.objective(a);
+    cache.objective(c);
+    EXPECT_EQ(problem.objectives, 3);
+    cache.objective(b);
+    EXPECT_EQ(problem.objectives, 4);
+
+    EXPECT_EQ(cache.hits(), 3);
+    EXPECT_EQ(cache.evaluations(), 4);
+}
+
+TEST_F(EvaluationCacheTest, LargerCapacityKeepsMorePoints) {
+    EvaluationCache wide(&problem, 3);
+    for (const ManifoldPoint* x : {&a, &b, &c, &a, &b, &c}) {
+        wide.objective(*x);
+    }
+    EXPECT_EQ(problem.objectives, 3);
+    EXPECT_EQ(wide.hits(), 3);
+}
+
+TEST_F(EvaluationCacheTest, MatchesPointsExactly) {
+    cache.objective(a);
+    const ManifoldPoint near(ScalarProblem::scalar(std::nextafter(1.0, 2.0)));
+    cache.objective(near);
+    EXPECT_EQ(problem.objectives, 2);
+
+    // A copy of a is the same point
+    const ManifoldPoint copy(a);
+    cache.objective(copy);
+    EXPECT_EQ(problem.objectives, 2);
+}
+
+TEST_F(EvaluationCacheTest, BatchAnswersCachedPointsAndSkipsTheCache) {
+    cache.objective(a);
+    std::vector<double> values;
+    cache.objective_batch({&a, &b, &c}, values);
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_EQ(values[0], 0.5);
+    EXPECT_EQ(values[1], 2.0);
+    EXPECT_EQ(values[2], 4.5);
+    EXPECT_EQ(problem.batches, 1);
+    EXPECT_EQ(problem.batch_points, 2);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.evaluations(), 3);
+
+    // The batch evicted nothing and cached nothing
+    cache.objective(a);
+    EXPECT_EQ(problem.objectives, 1);
+    cache.objective(b);
+    EXPECT_EQ(problem.objectives, 2);
+
+    // store_objective records a batch value for later
+    cache.store_objective(c, values[2]);
+    EXPECT_EQ(cache.objective(c), 4.5);
+    EXPECT_EQ(problem.objectives, 2);
+
+    // Nothing to evaluate, no batch call
+    cache.objective_batch({&c, &c}, values);
+    EXPECT_EQ(problem.batches, 1);
+}
+
+TEST_F(EvaluationCacheTest, ClearDropsEveryPoint) {
+    cache.objective_and_gradient(a);
+    cache.objective(b);
+    cache.clear();
+    cache.objective(a);
+    cache.gradient(a);
+    cache.objective(b);
+    EXPECT_EQ(problem.objectives, 4);
+    EXPECT_EQ(problem.gradients, 2);
+}
+
+TEST_F(EvaluationCacheTest, FusedEvaluationHasItsOwnPhase) {
+    SolverStats stats;
+    cache.set_stats(&stats);
+    cache.objective_and_gradient(a);
+    EXPECT_EQ(stats.calls[PHASE_OBJECTIVE_AND_GRADIENT], 1);
+    EXPECT_EQ(stats.calls[PHASE_OBJECTIVE], 0);
+    EXPECT_EQ(stats.calls[PHASE_GRADIENT], 0);
+
+    // With f cached only the gradient is evaluated, and the other way round
+    cache.objective(b);
+    cache.objective_and_gradient(b);
+    cache.gradient(c);
+    cache.objective_and_gradient(c);
+    EXPECT_EQ(stats.calls[PHASE_OBJECTIVE_AND_GRADIENT], 1);
+    EXPECT_EQ(stats.calls[PHASE_OBJECTIVE], 2);
+    EXPECT_EQ(stats.calls[PHASE_GRADIENT], 2);
+    EXPECT_EQ(problem.objectives, 3);
+    EXPECT_EQ(problem.gradients, 3);
+}
+
+TEST(EvaluationCacheHessianTest, OutputMayAliasDirection) {
+    // Brockett's Hessian conversion on Stiefel reads eta, for the converted
+    // Euclidean Hessian as well as for finite differences
+    for (bool euclidean_hessian : {true, false}) {
+        la::set_seed(3);
+        Brockett problem(8, 3, CANONICAL, euclidean_hessian);
+        const ManifoldPoint x = problem.start();
+        const ManifoldVector eta = problem.get_manifold()->projection(
+            x, ManifoldVector(la::mat(la::randn(8, 3))));
+
+        EvaluationCache cache(&problem);
+        ManifoldVector expected;
+        cache.hessian_vector(x, eta, expected);
+        ManifoldVector inout = eta;
+        cache.hessian_vector(x, inout, inout);
+        EXPECT_LT(la::norm_fro(la::mat(inout.as_mat() - expected.as_mat())), 1e-12)
+            << "Euclidean Hessian " << euclidean_hessian;
+    }
+}
+
+} // namespace
@@ -0,0 +1,157 @@
+// Points and problems shared by the tests
+#ifndef OPTIMLIGHT_TEST_HELPERS_HPP
+#define OPTIMLIGHT_TEST_HELPERS_HPP
+
+#include "problem.hpp"
+#include "manifolds/euclidean.hpp"
+#include "manifolds/linalg.hpp"
+#include "manifolds/manifold.hpp"
+#include "manifolds/stiefel.hpp"
+#include <complex>
+#include <functional>
+#include <utility>
+
+namespace OptimLight {
+namespace test {
+
+// n x p matrix of standard normal entries over T
+template <typename T> la::Mat<T> random_mat(int n, int p);
+template <> inline la::mat random_mat<double>(int n, int p) { return la::randn(n, p); }
+template <> inline la::cx_mat random_mat<la::cx_double>(int n, int p) {
+    return la::complex(la::randn(n, p), la::randn(n, p));
+}
+
+// A point of St(n, p) over T, from the QR factorisation of a Gaussian matrix
+template <typename T>
+la::Mat<T> stiefel_point(int n, int p) {
+    la::Mat<T> Q(n, p), R(p, p);
+    la::qr_econ(Q, R, random_mat<T>(n, p));
+    return Q;
+}
+
+// Frobenius norm of X^H X - I
+template <typename T>
+double orthonormality_error(const la::Mat<T>& X) {
+    la::Mat<T> G = la::adjoint(X) * X;
+    la::add_identity(G, T(-1.0));
+    return la::norm_fro(G);
+}
+
+// Brockett cost f(X) = Re tr(X^H A X N) on St(n, p) over T, A Hermitian
+// and N = diag(p, ..., 1). Its minimum is sum_i N_ii lambda_i over the
+// eigenvalues of A in ascending order.
+template <typename T>
+class BasicBrockett : public Problem {
+public:
+    typedef la::Mat<T> Mat;
+
+    BasicBrockett(int n, int p, MetricType metric, bool euclidean_hessian = false)
+        : stiefel_(n, p, metric), euclidean_hessian_(euclidean_hessian) {
+        const Mat B = random_mat<T>(n, n);
+        A_ = B + la::adjoint(B);
+        N_ = Mat(p, p);
+        la::set_identity(N_);
+        for (int i = 0; i < p; ++i) {
+            N_(i, i) = T(p - i);
+        }
+        set_manifold(&stiefel_);
+    }
+    BasicBrockett(const BasicBrockett&) = delete;
+    BasicBrockett& operator=(const BasicBrockett&) = delete;
+
+    double objective_function(const ManifoldPoint& x) const override {
+        const Mat& X = x.template as<T>();
+        const Mat XtAX = la::adjoint(X) * A_ * X;
+        return la::inner(XtAX, N_);
+    }
+
+    ManifoldVector gradient(const ManifoldPoint& x) const override {
+        return ManifoldVector(Mat(T(2.0) * A_ * x.template as<T>() * N_));
+    }
+
+    ManifoldVector euclidean_hessian_vector(const ManifoldPoint&,
+                                            const ManifoldVector& eta) const override {
+        return ManifoldVector(Mat(T(2.0) * A_ * eta.template as<T>() * N_));
+    }
+    bool has_euclidean_hessian() const override { return euclidean_hessian_; }
+
+    double optimum() const {
+        la::vec d;
+        Mat V(la::rows(A_), la::cols(A_));
+        la::eig_sym(d, V, A_);
+        double f = 0.0;
+        for (size_t i = 0; i < la::cols(N_); ++i) {
+            f += std::real(N_(i, i)) * d(i);
+        }
+        return f;
+    }
+
+    // The eigenvectors of the p smallest eigenvalues, smallest first, at
+    // which f reaches optimum()
+    ManifoldPoint minimizer() const {
+        la::vec d;
+        Mat V(la::rows(A_), la::cols(A_));
+        la::eig_sym(d, V, A_);
+        return ManifoldPoint(Mat(la::block(V, 0, 0, stiefel_.n, stiefel_.p)));
+    }
+
+    // A random starting point
+    ManifoldPoint start() const { return ManifoldPoint(stiefel_point<T>(stiefel_.n, stiefel_.p)); }
+
+    const Stiefel<T>& stiefel() const { return stiefel_; }
+
+private:
+    Stiefel<T> stiefel_;
+    bool euclidean_hessian_;
+    Mat A_;
+    Mat N_;
+};
+
+typedef BasicBrockett<double> Brockett;
+
+// f(x) for real x, on Euclidean(1, 1), with its first two derivatives
+class ScalarProblem : public Problem {
+public:
+    typedef std::function<double(double)> Function;
+
+    ScalarProblem(Function f, Function df, Function d2f)
+        : space_(1, 1), f_(f), df_(df), d2f_(d2f) {
+        set_manifold(&space_);
+    }
+
+    // Copies point at their own manifold
+    ScalarProblem(const ScalarProblem& other)
+        : Problem(other), space_(other.space_), f_(other.f_), df_(other.df_), d2f_(other.d2f_) {
+        set_manifold(&space_);
+    }
+    ScalarProblem& operator=(const ScalarProblem&) = delete;
+
+    double objective_function(const ManifoldPoint& x) const override {
+        return f_(x.as_mat()(0, 0));
+    }
+
+    ManifoldVector gradient(const ManifoldPoint& x) const override {
+        return scalar(df_(x.as_mat()(0, 0)));
+    }
+
+    ManifoldVector euclidean_hessian_vector(const ManifoldPoint& x,
+                                            const ManifoldVector& eta) const override {
+        return scalar(d2f_(x.as_mat()(0, 0)) * eta.as_mat()(0, 0));
+    }
+    bool has_euclidean_hessian() const override { return true; }
+
+    static ManifoldVector scalar(double value) {
+        la::mat m = la::zeros(1, 1);
+        m(0, 0) = value;
+        return ManifoldVector(std::move(m));
+    }
+
+private:
+    Euclidean<double> space_;
+    Function f_, df_, d2f_;
+};
+
+} // namespace test
+} // namespace OptimLight
+
+#endif // OPTIMLIGHT_TEST_HELPERS_HPP
@@ -0,0 +1,119 @@
+#include "test_helpers.hpp"
+#include "evaluation_cache.hpp"
+#include "optimizers/line_search/line_search_base.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// phi(t) = f(1 + t d) for f = x^2 / 2, whose exact minimizer is t = -1/d
+class LineSearchTest : public ::testing::Test {
+protected:
+    LineSearchTest()
+        : problem([](double x) { return 0.5 * x * x; },
+                  [](double x) { return x; },
+                  [](double) { return 1.0; }),
+          cache(&problem), x(ScalarProblem::scalar(1.0)) {}
+
+    // Search along d and check what every variant guarantees
+    bool search(LineSearcher& ls, double d) {
+        direction = ScalarProblem::scalar(d);
+        slope = d;  // f'(1) d
+        const bool found = ls.search(cache, x, direction, f0, slope);
+        if (found) {
+            const double t = ls.step();
+            EXPECT_DOUBLE_EQ(ls.step_vector().as_mat()(0, 0), t * d);
+            EXPECT_DOUBLE_EQ(ls.point().as_mat()(0, 0), 1.0 + t * d);
+            EXPECT_DOUBLE_EQ(ls.value(), problem.objective_function(ls.point()));
+            EXPECT_LE(ls.value(), f0 + 1e-4 * t * slope) << "sufficient decrease, d = " << d;
+        }
+        return found;
+    }
+
+    // phi'(t) at the accepted step
+    double derivative(const LineSearcher& ls) const {
+        return ls.point().as_mat()(0, 0) * direction.as_mat()(0, 0);
+    }
+
+    ScalarProblem problem;
+    EvaluationCache cache;
+    ManifoldPoint x;
+    ManifoldVector direction;
+    const double f0 = 0.5;
+    double slope = 0.0;
+};
+
+TEST_F(LineSearchTest, ArmijoAcceptsUnitStepWhenItDecreasesEnough) {
+    LineSearcher ls(LineSearch::LINESEARCH_ARMIJO);
+    ASSERT_TRUE(search(ls, -1.0));
+    EXPECT_EQ(ls.step(), 1.0);
+    EXPECT_EQ(ls.function_evaluations(), 1);
+    EXPECT_EQ(ls.gradient_evaluations(), 0);
+    EXPECT_FALSE(ls.has_gradient());
+}
+
+TEST_F(LineSearchTest, ArmijoBacktracksByInterpolation) {
+    // phi is quadratic, so the interpolation after the rejected unit step
+    // lands on the minimizer 0.1, the largest shrink allowed
+    LineSearcher ls(LineSearch::LINESEARCH_ARMIJO);
+    ASSERT_TRUE(search(ls, -10.0));
+    EXPECT_NEAR(ls.step(), 0.1, 1e-15);
+    EXPECT_EQ(ls.function_evaluations(), 2);
+}
+
+TEST_F(LineSearchTest, ArmijoFailsWithinBudget) {
+    LineSearcher ls(LineSearch::LINESEARCH_ARMIJO);
+    ls.set_max_evaluations(1);
+    EXPECT_FALSE(search(ls, -10.0));
+}
+
+TEST_F(LineSearchTest, SpeculativeTrialsTakeLongestAcceptableStep) {
+    // Trials 1, 1/2, 1/4 and 1/8 are evaluated together; only 1/8 passes
+    LineSearcher ls(LineSearch::LINESEARCH_ARMIJO);
+    ls.set_speculative_trials(4);
+    ASSERT_TRUE(search(ls, -10.0));
+    EXPECT_EQ(ls.step(), 0.125);
+    EXPECT_EQ(ls.function_evaluations(), 4);
+    // The accepted point is in the cache
+    EXPECT_EQ(cache.objective(ls.point()), ls.value());
+}
+
+TEST_F(LineSearchTest, WolfeConditionsHold) {
+    for (LineSearch type : {LineSearch::LINESEARCH_WOLFE, LineSearch::LINESEARCH_STRONG_WOLFE,
+                            LineSearch::LINESEARCH_EXACT}) {
+        for (double d : {-0.01, -0.5, -1.0, -10.0, -1000.0}) {
+            LineSearcher ls(type);
+            ASSERT_TRUE(search(ls, d)) << "type " << static_cast<int>(type) << ", d = " << d;
+            ASSERT_TRUE(ls.has_gradient());
+            EXPECT_DOUBLE_EQ(ls.gradient().as_mat()(0, 0), ls.point().as_mat()(0, 0));
+
+            const double dphi = derivative(ls);
+            if (type == LineSearch::LINESEARCH_WOLFE) {
+                EXPECT_GE(dphi, 0.9 * slope) << "d = " << d;
+            } else {
+                const double c2 = type == LineSearch::LINESEARCH_EXACT ? 1e-2 : 0.9;
+                EXPECT_LE(std::abs(dphi), -c2 * slope) << "type " << static_cast<int>(type)
+                                                      << ", d = " << d;
+            }
+        }
+    }
+}
+
+TEST_F(LineSearchTest, WolfeExtrapolatesShortSteps) {
+    // The unit step along d = -0.01 barely moves, so the search grows it
+    LineSearcher ls(LineSearch::LINESEARCH_WOLFE);
+    ASSERT_TRUE(search(ls, -0.01));
+    EXPECT_GT(ls.step(), 1.0);
+}
+
+TEST_F(LineSearchTest, RejectsAscentDirection) {
+    LineSearcher ls;
+    direction = ScalarProblem::scalar(1.0);
+    EXPECT_THROW(ls.search(cache, x, direction, f0, 1.0), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,119 @@
+#include "test_helpers.hpp"
+#include "multi_start.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// f = -cos 3x + x^2 / 10 has a local minimum near every multiple of 2 pi / 3
+// and its global one at 0, f = -1
+ScalarProblem wells() {
+    return ScalarProblem([](double x) { return -std::cos(3.0 * x) + 0.1 * x * x; },
+                         [](double x) { return 3.0 * std::sin(3.0 * x) + 0.2 * x; },
+                         [](double x) { return 9.0 * std::cos(3.0 * x) + 0.2; });
+}
+
+std::vector<ManifoldPoint> grid() {
+    std::vector<ManifoldPoint> starts;
+    for (int i = 0; i <= 24; ++i) {
+        starts.push_back(ScalarProblem::scalar(-6.0 + 0.5 * i));
+    }
+    return starts;
+}
+
+void expect_same_outcomes(const MultiStart& a, const MultiStart& b) {
+    ASSERT_EQ(a.outcomes().size(), b.outcomes().size());
+    for (size_t i = 0; i < a.outcomes().size(); ++i) {
+        EXPECT_EQ(a.outcomes()[i].result, b.outcomes()[i].result) << "start " << i;
+        EXPECT_EQ(a.outcomes()[i].value, b.outcomes()[i].value) << "start " << i;
+        EXPECT_EQ(a.outcomes()[i].iterations, b.outcomes()[i].iterations) << "start " << i;
+    }
+    EXPECT_EQ(a.best_index(), b.best_index());
+    EXPECT_EQ(a.best_value(), b.best_value());
+}
+
+TEST(MultiStartTest, MatchesSequentialRuns) {
+    ScalarProblem problem = wells();
+    const std::vector<ManifoldPoint> starts = grid();
+
+    // Each start on its own, with the lowest index winning ties
+    std::vector<double> values;
+    int best = -1;
+    for (size_t i = 0; i < starts.size(); ++i) {
+        ManifoldPoint x = starts[i];
+        Optimizer optimizer(&problem);
+        optimizer.set_tol(1e-8);
+        optimizer.run(x);
+        values.push_back(optimizer.get_solver().f_value());
+        if (best < 0 || values[i] < values[best]) {
+            best = static_cast<int>(i);
+        }
+    }
+    EXPECT_NEAR(values[best], -1.0, 1e-12);
+
+    MultiStart sequential(&problem);
+    sequential.set_tol(1e-8);
+    sequential.set_prune_gap(-1.0);
+    EXPECT_EQ(sequential.run(starts), best);
+    EXPECT_EQ(sequential.best_value(), values[best]);
+    EXPECT_EQ(sequential.num_pruned(), 0);
+    for (size_t i = 0; i < starts.size(); ++i) {
+        EXPECT_EQ(sequential.outcomes()[i].value, values[i]) << "start " << i;
+    }
+
+    MultiStart parallel(&problem);
+    parallel.set_num_threads(4);
+    parallel.set_tol(1e-8);
+    parallel.set_prune_gap(-1.0);
+    parallel.run(starts);
+    expect_same_outcomes(parallel, sequential);
+    EXPECT_NEAR(parallel.best_point().as_mat()(0, 0), 0.0, 1e-6);
+}
+
+TEST(MultiStartTest, PrunesLosingStartsDeterministically) {
+    ScalarProblem problem = wells();
+    const std::vector<ManifoldPoint> starts = grid();
+
+    MultiStart full(&problem);
+    full.set_tol(1e-8);
+    full.set_prune_gap(-1.0);
+    full.run(starts);
+
+    // One thread visits the starts in a fixed order, so pruning is repeatable
+    MultiStart pruned(&problem);
+    pruned.set_tol(1e-8);
+    pruned.set_prune_window(1);
+    pruned.run(starts);
+    EXPECT_GT(pruned.num_pruned(), 0);
+    EXPECT_EQ(pruned.best_index(), full.best_index());
+    EXPECT_EQ(pruned.best_value(), full.best_value());
+    for (const MultiStart::Outcome& outcome : pruned.outcomes()) {
+        if (outcome.result == Result::RESULT_STOPPED) {
+            EXPECT_GT(outcome.value, pruned.best_value());
+            EXPECT_GT(outcome.iterations, 1);
+        }
+    }
+
+    MultiStart again(&problem);
+    again.set_tol(1e-8);
+    again.set_prune_window(1);
+    again.run(starts);
+    expect_same_outcomes(again, pruned);
+
+    // A second run of the same object starts afresh
+    pruned.run(starts);
+    expect_same_outcomes(again, pruned);
+}
+
+TEST(MultiStartTest, RejectsEmptyStarts) {
+    ScalarProblem problem = wells();
+    MultiStart ms(&problem);
+    EXPECT_THROW(ms.run({}), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,219 @@
+#include "test_helpers.hpp"
+#include "manifolds/product_manifold.hpp"
+#include "manifolds/stiefel.hpp"
+#include "manifolds/thread_pool.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// St(6, 2) over the reals times St(5, 2) over the complex numbers. The
+// product is complex; the real factor works on the real parts of its rows.
+class MixedProductTest : public ::testing::Test {
+protected:
+    MixedProductTest()
+        : R(6, 2), C(5, 2), P({&R, &C}, {1, 1}), x(11, 2, true) {}
+
+    void SetUp() override {
+        la::set_seed(7);
+        Xr = stiefel_point<double>(6, 2);
+        Xc = stiefel_point<la::cx_double>(5, 2);
+        la::block(x.as_cx_mat(), 0, 0, 6, 2) = la::to_complex(Xr);
+        la::block(x.as_cx_mat(), 6, 0, 5, 2) = Xc;
+        v = ManifoldVector(random_mat<la::cx_double>(11, 2));
+    }
+
+    static la::cx_mat top(const Array& a) { return la::block(a.as_cx_mat(), 0, 0, 6, 2); }
+    static la::cx_mat bottom(const Array& a) { return la::block(a.as_cx_mat(), 6, 0, 5, 2); }
+
+    Stiefel<double> R;
+    Stiefel<la::cx_double> C;
+    ProductManifold P;
+    ManifoldPoint x;
+    ManifoldVector v;
+    la::mat Xr;
+    la::cx_mat Xc;
+};
+
+TEST_F(MixedProductTest, IsComplex) {
+    EXPECT_TRUE(P.empty.is_complex());
+    EXPECT_EQ(P.dimension(), R.dimension() + C.dimension());
+}
+
+TEST_F(MixedProductTest, ProjectionMatchesComponents) {
+    const ManifoldVector eta = P.projection(x, v);
+    const ManifoldVector eta_r = R.projection(ManifoldPoint(Xr), ManifoldVector(la::real(top(v))));
+    const ManifoldVector eta_c = C.projection(ManifoldPoint(Xc), ManifoldVector(bottom(v)));
+
+    EXPECT_EQ(la::norm_fro(la::imag(top(eta))), 0.0);
+    EXPECT_LT(la::norm_fro(la::mat(la::real(top(eta)) - eta_r.as_mat())), 1e-14);
+    EXPECT_LT(la::norm_fro(la::cx_mat(bottom(eta) - eta_c.as_cx_mat())), 1e-14);
+
+    const double expected = R.metric(ManifoldPoint(Xr), eta_r, eta_r) +
+                            C.metric(ManifoldPoint(Xc), eta_c, eta_c);
+    EXPECT_NEAR(P.metric(x, eta, eta), expected, 1e-12);
+}
+
+TEST_F(MixedProductTest, RetractionStaysOnManifold) {
+    ManifoldVector eta = P.projection(x, v);
+    eta *= 0.1;
+    const ManifoldPoint y = P.retraction(x, eta);
+
+    EXPECT_EQ(la::norm_fro(la::imag(top(y))), 0.0);
+    EXPECT_LT(orthonormality_error<double>(la::real(top(y))), 1e-12);
+    EXPECT_LT(orthonormality_error<la::cx_double>(bottom(y)), 1e-12);
+
+    // The line-search curve goes through the adapter as well
+    ManifoldPoint z;
+    P.retraction_curve(x, eta)->evaluate(1.0, z);
+    EXPECT_LT(la::norm_fro(la::cx_mat(z.as_cx_mat() - y.as_cx_mat())), 1e-12);
+}
+
+TEST_F(MixedProductTest, TransportIsTangent) {
+    ManifoldVector eta = P.projection(x, v);
+    eta *= 0.1;
+    const ManifoldPoint y = P.retraction(x, eta);
+    ManifoldVector xi = P.projection(x, ManifoldVector(random_mat<la::cx_double>(11, 2)));
+    const ManifoldVector single = P.vector_transport(x, eta, y, xi);
+
+    EXPECT_EQ(la::norm_fro(la::imag(top(single))), 0.0);
+    const ManifoldVector again = P.projection(y, single);
+    EXPECT_LT(la::norm_fro(la::cx_mat(again.as_cx_mat() - single.as_cx_mat())), 1e-12);
+
+    P.vector_transport_many(x, eta, y, {&xi});
+    EXPECT_LT(la::norm_fro(la::cx_mat(xi.as_cx_mat() - single.as_cx_mat())), 1e-12);
+}
+
+TEST_F(MixedProductTest, GradientConversion) {
+    ManifoldVector rgrad;
+    const double norm = P.egrad_to_rgrad(x, v, rgrad);
+    EXPECT_EQ(la::norm_fro(la::imag(top(rgrad))), 0.0);
+    EXPECT_NEAR(norm * norm, P.metric(x, rgrad, rgrad), 1e-10);
+}
+
+TEST(ProductCurveTest, MatchesRetractionAndRebinds) {
+    // Components whose curves share factorisations across t
+    la::set_seed(5);
+    Stiefel<double> A(6, 2, CANONICAL, RT_CAYLEY);
+    Stiefel<double> B(5, 2, CANONICAL, RT_POLAR_NS);
+    ProductManifold P({&A, &B}, {1, 2});
+    auto point = [] {
+        ManifoldPoint x(16, 2);
+        la::block(x.as_mat(), 0, 0, 6, 2) = stiefel_point<double>(6, 2);
+        la::block(x.as_mat(), 6, 0, 5, 2) = stiefel_point<double>(5, 2);
+        la::block(x.as_mat(), 11, 0, 5, 2) = stiefel_point<double>(5, 2);
+        return x;
+    };
+    auto check = [&P](const ManifoldPoint& x, const ManifoldVector& eta,
+                      const RetractionCurve& curve) {
+        ManifoldPoint y;
+        for (double t : {-1.0, -0.2, 0.5, 1.0, 3.0}) {
+            ManifoldVector step = eta;
+            step *= t;
+            curve.evaluate(t, y);
+            EXPECT_LT(la::norm_fro(la::mat(y.as_mat() - P.retraction(x, step).as_mat())), 1e-12)
+                << "t = " << t;
+        }
+    };
+
+    const ManifoldPoint x = point();
+    const ManifoldVector eta = P.projection(x, ManifoldVector(la::mat(la::randn(16, 2))));
+    std::unique_ptr<RetractionCurve> curve;
+    P.retraction_curve_into(x, eta, curve);
+    ASSERT_TRUE(curve);
+    check(x, eta, *curve);
+
+    const ManifoldPoint x2 = point();
+    const ManifoldVector eta2 = P.projection(x2, ManifoldVector(la::mat(la::randn(16, 2))));
+    RetractionCurve* const before = curve.get();
+    P.retraction_curve_into(x2, eta2, curve);
+    EXPECT_EQ(curve.get(), before);
+    check(x2, eta2, *curve);
+}
+
+TEST(ThreadPoolTest, NestedRunRunsInline) {
+    // A task calling run() on its own pool, as a product listed in itself
+    // would, finds the pool busy and runs the inner tasks on its thread
+    ThreadPool pool(3);
+    const std::vector<size_t> outer = {0, 1, 2, 3, 4, 5, 6, 7};
+    const std::vector<size_t> inner = {0, 1, 2, 3};
+    std::atomic<int> count(0);
+    pool.run(outer, [&](size_t) {
+        // Long enough for the workers to pick up outer tasks
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        pool.run(inner, [&](size_t) { count.fetch_add(1); });
+    });
+    EXPECT_EQ(count.load(), 32);
+
+    // The pool is free again afterwards, and errors still propagate
+    EXPECT_THROW(pool.run(outer, [&](size_t i) {
+        pool.run(inner, [&](size_t j) {
+            if (i == 3 && j == 2) {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }), std::runtime_error);
+    count = 0;
+    pool.run(outer, [&](size_t) { count.fetch_add(1); });
+    EXPECT_EQ(count.load(), 8);
+}
+
+TEST(ProductPoolTest, SharedPoolIsSafe) {
+    // A threaded product listed twice in a threaded product, and copies of
+    // it used from two threads, all run on the same pool
+    la::set_seed(9);
+    Stiefel<double> A(7, 2);
+    Stiefel<double> B(5, 2);
+    ProductManifold inner({&A, &B}, {2, 2});
+    inner.set_num_threads(3);
+    ProductManifold outer({&inner}, {2});
+    outer.set_num_threads(2);
+
+    const int rows = 2 * 24;
+    ManifoldPoint x(rows, 2);
+    for (int k = 0; k < 2; ++k) {
+        la::block(x.as_mat(), 24 * k, 0, 7, 2) = stiefel_point<double>(7, 2);
+        la::block(x.as_mat(), 24 * k + 7, 0, 7, 2) = stiefel_point<double>(7, 2);
+        la::block(x.as_mat(), 24 * k + 14, 0, 5, 2) = stiefel_point<double>(5, 2);
+        la::block(x.as_mat(), 24 * k + 19, 0, 5, 2) = stiefel_point<double>(5, 2);
+    }
+    const ManifoldVector v(la::mat(la::randn(rows, 2)));
+
+    ProductManifold sequential({&A, &B}, {2, 2});
+    ProductManifold reference({&sequential}, {2});
+    const ManifoldVector expected = reference.projection(x, v);
+    for (int repeat = 0; repeat < 20; ++repeat) {
+        const ManifoldVector eta = outer.projection(x, v);
+        ASSERT_LT(la::norm_fro(la::mat(eta.as_mat() - expected.as_mat())), 1e-14);
+    }
+
+    const ManifoldPoint x1(la::mat(la::block(x.as_mat(), 0, 0, 24, 2)));
+    const ManifoldVector v1(la::mat(la::block(v.as_mat(), 0, 0, 24, 2)));
+    const ManifoldVector expected1 = sequential.projection(x1, v1);
+    const ProductManifold copy(inner);
+    std::vector<double> errors(2, 0.0);
+    auto use = [&](const ProductManifold& M, double& error) {
+        for (int repeat = 0; repeat < 200; ++repeat) {
+            const ManifoldVector eta = M.projection(x1, v1);
+            error = std::max(error, la::norm_fro(la::mat(eta.as_mat() - expected1.as_mat())));
+        }
+    };
+    std::thread first(use, std::cref(inner), std::ref(errors[0]));
+    std::thread second(use, std::cref(copy), std::ref(errors[1]));
+    first.join();
+    second.join();
+    EXPECT_LT(errors[0], 1e-14);
+    EXPECT_LT(errors[1], 1e-14);
+}
+
+} // namespace
@@ -0,0 +1,312 @@
+#include "test_helpers.hpp"
+#include "optimizers/line_search/lbfgs.hpp"
+#include "optimizers/trust_region/trust_region.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+bool converged(Result result) {
+    return result == Result::RESULT_GTOL_REACHED || result == Result::RESULT_FTOLREL_REACHED;
+}
+
+double value_of(const ManifoldPoint& x) { return x.as_mat()(0, 0); }
+
+// f = cos x, concave around 0, so a steepest-descent step from there
+// lowers f while the slope keeps falling: <s, y> < 0
+ScalarProblem cosine() {
+    return ScalarProblem([](double x) { return std::cos(x); },
+                         [](double x) { return -std::sin(x); },
+                         [](double x) { return -std::cos(x); });
+}
+
+ScalarProblem quadratic() {
+    return ScalarProblem([](double x) { return 0.5 * x * x; },
+                         [](double x) { return x; },
+                         [](double) { return 1.0; });
+}
+
+// f = x^4 / 4, whose degenerate minimum L-BFGS only approaches linearly,
+// with a fixed sleep in every objective and gradient evaluation
+class SlowQuartic : public ScalarProblem {
+public:
+    explicit SlowQuartic(double seconds)
+        : ScalarProblem([](double x) { return 0.25 * x * x * x * x; },
+                        [](double x) { return x * x * x; },
+                        [](double x) { return 3.0 * x * x; }),
+          delay_(seconds) {}
+
+    double objective_function(const ManifoldPoint& x) const override {
+        ++evaluations;
+        std::this_thread::sleep_for(delay_);
+        return ScalarProblem::objective_function(x);
+    }
+
+    ManifoldVector gradient(const ManifoldPoint& x) const override {
+        ++evaluations;
+        std::this_thread::sleep_for(delay_);
+        return ScalarProblem::gradient(x);
+    }
+
+    double delay() const { return delay_.count(); }
+
+    mutable int evaluations = 0;
+
+private:
+    std::chrono::duration<double> delay_;
+};
+
+TEST(SolverTest, StopsBeforeExceedingMaxTime) {
+    SlowQuartic problem(0.005);
+    ManifoldPoint x = ScalarProblem::scalar(0.7);
+    LBFGS solver(&problem);
+    solver.set_gtol(0.0);
+    solver.set_ftol_rel(0.0);
+    const double max_time = 0.2;
+    solver.set_max_time(max_time);
+    EXPECT_EQ(solver.minimize(x), Result::RESULT_MAXTIME_REACHED);
+
+    // The run ends before an iteration that would overrun, not after it,
+    // and no earlier than one iteration ahead of the limit
+    const SolverStats& stats = solver.stats();
+    ASSERT_GT(solver.iterations(), 3);
+    const double per_iteration = stats.total_seconds / solver.iterations();
+    EXPECT_LT(stats.total_seconds, max_time);
+    EXPECT_GT(stats.total_seconds + 2.0 * per_iteration, max_time);
+    EXPECT_LT(value_of(x), 0.7);
+}
+
+TEST(SolverTest, RecordsPhaseTimings) {
+    SlowQuartic problem(0.002);
+    ManifoldPoint x = ScalarProblem::scalar(0.7);
+    LBFGS solver(&problem);
+    solver.set_max_iter(10);
+    solver.set_gtol(0.0);
+    solver.set_ftol_rel(0.0);
+    EXPECT_EQ(solver.minimize(x), Result::RESULT_MAXITER_REACHED);
+
+    const SolverStats& stats = solver.stats();
+    EXPECT_EQ(stats.iterations, 10);
+    EXPECT_EQ(stats.calls[PHASE_LINE_SEARCH], 10);
+    EXPECT_GE(stats.calls[PHASE_RETRACTION], 10);
+    EXPECT_EQ(stats.calls[PHASE_HESSIAN], 0);
+
+    // Every sleep is inside an objective or gradient timer
+    EXPECT_GT(stats.calls[PHASE_OBJECTIVE], 0);
+    EXPECT_GT(stats.calls[PHASE_GRADIENT], 0);
+    const double evaluation_seconds = stats.seconds[PHASE_OBJECTIVE] + stats.seconds[PHASE_GRADIENT] +
+                                      stats.seconds[PHASE_OBJECTIVE_AND_GRADIENT];
+    EXPECT_GE(evaluation_seconds, problem.evaluations * problem.delay());
+    EXPECT_LE(evaluation_seconds, stats.total_seconds);
+    // The line search time includes the evaluations made in it
+    EXPECT_LE(stats.seconds[PHASE_LINE_SEARCH], stats.total_seconds);
+    EXPECT_GE(stats.seconds[PHASE_LINE_SEARCH], stats.seconds[PHASE_RETRACTION]);
+
+    for (int i = 0; i < PhaseLength; ++i) {
+        EXPECT_NE(stats.report().find(phase_to_string(static_cast<Phase>(i))), std::string::npos);
+    }
+
+    // Timing off leaves the stats empty
+    solver.set_timing(false);
+    x = ScalarProblem::scalar(0.7);
+    solver.minimize(x);
+    for (int i = 0; i < PhaseLength; ++i) {
+        EXPECT_EQ(solver.stats().calls[i], 0) << phase_to_string(static_cast<Phase>(i));
+    }
+    EXPECT_EQ(solver.stats().iterations, 10);
+}
+
+// f = x^2 / 2 whose objective and gradient are evaluated together
+class FusedQuadratic : public ScalarProblem {
+public:
+    FusedQuadratic()
+        : ScalarProblem([](double x) { return 0.5 * x * x; },
+                        [](double x) { return x; },
+                        [](double) { return 1.0; }) {}
+
+    void evaluate_obj_and_grad(const ManifoldPoint& x, EvaluationContext& ctx) const override {
+        ++fused;
+        const double v = value_of(x);
+        ctx.f = 0.5 * v * v;
+        ctx.egrad = scalar(v);
+        ctx.has_f = true;
+        ctx.has_egrad = true;
+    }
+
+    mutable int fused = 0;
+};
+
+TEST(SolverTest, StartsWithTheFusedEvaluation) {
+    for (bool trust_region : {false, true}) {
+        FusedQuadratic problem;
+        ManifoldPoint x = ScalarProblem::scalar(3.0);
+        std::unique_ptr<Solver> solver;
+        if (trust_region) {
+            solver.reset(new TrustRegion(&problem));
+        } else {
+            solver.reset(new LBFGS(&problem));
+        }
+        solver->set_gtol(1e-10);
+        EXPECT_TRUE(converged(solver->minimize(x))) << "trust region " << trust_region;
+        EXPECT_EQ(problem.fused, 1) << "trust region " << trust_region;
+        EXPECT_EQ(solver->stats().calls[PHASE_OBJECTIVE_AND_GRADIENT], 1) << "trust region " << trust_region;
+        EXPECT_NEAR(value_of(x), 0.0, 1e-8) << "trust region " << trust_region;
+    }
+}
+
+TEST(LBFGSTest, ConvergesOnBrockett) {
+    for (MetricType metric : {EUCLIDEAN, CANONICAL}) {
+        la::set_seed(5);
+        Brockett problem(30, 4, metric);
+        ManifoldPoint x = problem.start();
+        LBFGS solver(&problem);
+        solver.set_gtol(1e-8);
+        solver.set_max_iter(500);
+        EXPECT_TRUE(converged(solver.minimize(x))) << "metric " << metric;
+        EXPECT_NEAR(problem.objective_function(x), problem.optimum(), 1e-7) << "metric " << metric;
+        EXPECT_LE(solver.iterations(), 500);
+    }
+}
+
+TEST(LBFGSTest, ConvergesWithShortMemory) {
+    la::set_seed(5);
+    Brockett problem(30, 4, CANONICAL);
+    ManifoldPoint x = problem.start();
+    LBFGS solver(&problem, 2);
+    solver.set_gtol(1e-8);
+    solver.set_max_iter(2000);
+    EXPECT_TRUE(converged(solver.minimize(x)));
+    EXPECT_NEAR(problem.objective_function(x), problem.optimum(), 1e-7);
+    EXPECT_LE(solver.stored_pairs(), 2);
+}
+
+TEST(LBFGSTest, SkipsPairWithoutPositiveCurvature) {
+    // The Armijo search accepts the unit step without looking at the slope
+    // at the new point, so the pair of the first step has <s, y> < 0
+    ScalarProblem problem = cosine();
+    ManifoldPoint x = ScalarProblem::scalar(0.5);
+    LBFGS solver(&problem);
+    solver.line_search().set_type(LineSearch::LINESEARCH_ARMIJO);
+    solver.set_max_iter(1);
+    EXPECT_EQ(solver.minimize(x), Result::RESULT_MAXITER_REACHED);
+    EXPECT_GT(value_of(x), 0.5);
+    EXPECT_EQ(solver.stored_pairs(), 0);
+
+    // On a convex function the same step is stored
+    ScalarProblem convex = quadratic();
+    ManifoldPoint z = ScalarProblem::scalar(2.0);
+    LBFGS other(&convex);
+    other.line_search().set_type(LineSearch::LINESEARCH_ARMIJO);
+    other.set_max_iter(1);
+    other.minimize(z);
+    EXPECT_EQ(other.stored_pairs(), 1);
+
+    // Skipping keeps the direction a descent direction, and the run still
+    // reaches the minimum at pi
+    x = ScalarProblem::scalar(0.5);
+    solver.set_max_iter(100);
+    solver.set_gtol(1e-10);
+    EXPECT_TRUE(converged(solver.minimize(x)));
+    EXPECT_NEAR(value_of(x), std::acos(-1.0), 1e-8);
+}
+
+TEST(TrustRegionTest, ConvergesOnBrockett) {
+    for (MetricType metric : {EUCLIDEAN, CANONICAL}) {
+        for (bool euclidean_hessian : {false, true}) {
+            la::set_seed(5);
+            Brockett problem(30, 4, metric, euclidean_hessian);
+            ManifoldPoint x = problem.start();
+            TrustRegion solver(&problem);
+            solver.set_gtol(1e-8);
+            solver.set_max_iter(500);
+            EXPECT_TRUE(converged(solver.minimize(x)))
+                << "metric " << metric << ", Euclidean Hessian " << euclidean_hessian;
+            EXPECT_NEAR(problem.objective_function(x), problem.optimum(), 1e-7)
+                << "metric " << metric << ", Euclidean Hessian " << euclidean_hessian;
+        }
+    }
+}
+
+TEST(TrustRegionTest, InteriorNewtonStepKeepsRadius) {
+    // The Newton step -1 is well inside the region and exact, tCG stops
+    // on the residual after one inner iteration
+    ScalarProblem problem = quadratic();
+    ManifoldPoint x = ScalarProblem::scalar(1.0);
+    TrustRegion solver(&problem);
+    solver.set_radius(10.0, 10.0);
+    solver.set_max_iter(1);
+    solver.minimize(x);
+    EXPECT_NEAR(value_of(x), 0.0, 1e-12);
+    EXPECT_EQ(solver.inner_iterations(), 1);
+    EXPECT_EQ(solver.radius(), 10.0);
+}
+
+TEST(TrustRegionTest, BoundaryStepExpandsRadius) {
+    // The Newton step -5 leaves the region of radius 0.1, so tCG stops on
+    // the boundary; the model is exact, and the radius doubles
+    ScalarProblem problem = quadratic();
+    ManifoldPoint x = ScalarProblem::scalar(5.0);
+    TrustRegion solver(&problem);
+    solver.set_radius(10.0, 0.1);
+    solver.set_max_iter(1);
+    solver.minimize(x);
+    EXPECT_NEAR(value_of(x), 4.9, 1e-12);
+    EXPECT_EQ(solver.inner_iterations(), 1);
+    EXPECT_DOUBLE_EQ(solver.radius(), 0.2);
+
+    // The radius never exceeds Delta_bar
+    solver.set_radius(0.15, 0.1);
+    x = ScalarProblem::scalar(5.0);
+    solver.minimize(x);
+    EXPECT_DOUBLE_EQ(solver.radius(), 0.15);
+}
+
+TEST(TrustRegionTest, NegativeCurvatureGoesToBoundary) {
+    // f = -x^2/2 + x^4/4 has f'' = -0.97 at 0.1: tCG follows -grad to the
+    // boundary of the region of radius 0.5, and the good ratio
+    // (about 0.84) doubles the radius
+    ScalarProblem problem([](double x) { return -0.5 * x * x + 0.25 * x * x * x * x; },
+                          [](double x) { return -x + x * x * x; },
+                          [](double x) { return -1.0 + 3.0 * x * x; });
+    ManifoldPoint x = ScalarProblem::scalar(0.1);
+    TrustRegion solver(&problem);
+    solver.set_radius(10.0, 0.5);
+    solver.set_max_iter(1);
+    solver.minimize(x);
+    EXPECT_NEAR(value_of(x), 0.6, 1e-12);
+    EXPECT_DOUBLE_EQ(solver.radius(), 1.0);
+
+    // From there the run converges to the minimum at 1
+    solver.set_max_iter(100);
+    solver.set_gtol(1e-10);
+    EXPECT_TRUE(converged(solver.minimize(x)));
+    EXPECT_NEAR(value_of(x), 1.0, 1e-8);
+}
+
+TEST(TrustRegionTest, PoorModelRejectsStepAndShrinksRadius) {
+    // f = sqrt(1 + x^2) flattens out, so the Newton step from 2 to -8
+    // increases f; the step is rejected and the radius quartered
+    ScalarProblem problem([](double x) { return std::sqrt(1.0 + x * x); },
+                          [](double x) { return x / std::sqrt(1.0 + x * x); },
+                          [](double x) { return std::pow(1.0 + x * x, -1.5); });
+    ManifoldPoint x = ScalarProblem::scalar(2.0);
+    TrustRegion solver(&problem);
+    solver.set_radius(100.0, 20.0);
+    solver.set_max_iter(1);
+    EXPECT_EQ(solver.minimize(x), Result::RESULT_MAXITER_REACHED);
+    EXPECT_EQ(value_of(x), 2.0);
+    EXPECT_DOUBLE_EQ(solver.radius(), 5.0);
+
+    solver.set_max_iter(100);
+    solver.set_gtol(1e-10);
+    EXPECT_TRUE(converged(solver.minimize(x)));
+    EXPECT_NEAR(value_of(x), 0.0, 1e-8);
+}
+
+} // namespace
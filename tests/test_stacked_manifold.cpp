@@ -0,0 +1,131 @@
+#include "test_helpers.hpp"
+#include "manifolds/stacked_manifold.hpp"
+#include "manifolds/stiefel.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// The batched Stiefel kernels behind StackedManifold against one Stiefel
+// call per copy, over the reals and the complex numbers. The copies span
+// several chunks of 64, the last one partial, and both the n <= 16 kernels
+// and the general ones are covered.
+template <typename T>
+class StackedStiefelTest : public ::testing::Test {
+protected:
+    typedef la::Mat<T> Mat;
+
+    const int copies = 150;
+
+    // x, eta and xi hold `copies` blocks of n x p side by side: points, and
+    // tangent vectors at them
+    void make_data(const Stiefel<T>& S) {
+        const int n = S.n;
+        const int p = S.p;
+        Mat X(n, p * copies), Eta(n, p * copies), Xi(n, p * copies);
+        for (int i = 0; i < copies; ++i) {
+            const ManifoldPoint xi(stiefel_point<T>(n, p));
+            Mat eta = S.projection(xi, ManifoldVector(random_mat<T>(n, p))).template as<T>();
+            eta *= T(0.3);
+            la::block(X, 0, p * i, n, p) = xi.template as<T>();
+            la::block(Eta, 0, p * i, n, p) = eta;
+            la::block(Xi, 0, p * i, n, p) =
+                S.projection(xi, ManifoldVector(random_mat<T>(n, p))).template as<T>();
+        }
+        x = ManifoldPoint(X);
+        eta = ManifoldVector(Eta);
+        xi = ManifoldVector(Xi);
+    }
+
+    static Mat copy_of(const Array& a, int p, int i) {
+        return Mat(la::block(a.template as<T>(), 0, p * i, la::rows(a.template as<T>()), p));
+    }
+
+    // Largest distance between copy i of `stacked` and expected(i)
+    template <typename F>
+    double max_distance(const Array& stacked, int p, F expected) const {
+        double worst = 0.0;
+        for (int i = 0; i < copies; ++i) {
+            const Mat e = expected(i).template as<T>();
+            worst = std::max(worst, la::norm_fro(Mat(copy_of(stacked, p, i) - e)));
+        }
+        return worst;
+    }
+
+    void check(const Stiefel<T>& S, int num_threads) {
+        const int p = S.p;
+        StackedManifold M(&S, copies);
+        M.set_num_threads(num_threads);
+        make_data(S);
+        auto point = [&](const Array& a, int i) { return ManifoldPoint(copy_of(a, p, i)); };
+        auto vector = [&](const Array& a, int i) { return ManifoldVector(copy_of(a, p, i)); };
+
+        double expected = 0.0;
+        for (int i = 0; i < copies; ++i) {
+            expected += S.metric(point(x, i), vector(eta, i), vector(xi, i));
+        }
+        EXPECT_NEAR(M.metric(x, eta, xi), expected, 1e-12 * copies);
+
+        const ManifoldVector ambient(random_mat<T>(S.n, p * copies));
+        ManifoldVector projected;
+        M.projection_into(x, ambient, projected);
+        EXPECT_LT(max_distance(projected, p, [&](int i) {
+            return S.projection(point(x, i), vector(ambient, i));
+        }), 1e-12);
+
+        ManifoldPoint y;
+        M.retraction_into(x, eta, y);
+        EXPECT_LT(max_distance(y, p, [&](int i) {
+            return S.retraction(point(x, i), vector(eta, i));
+        }), 1e-12);
+
+        ManifoldVector transported;
+        M.vector_transport_into(x, eta, y, xi, transported);
+        EXPECT_LT(max_distance(transported, p, [&](int i) {
+            return S.vector_transport(point(x, i), vector(eta, i), point(y, i), vector(xi, i));
+        }), 1e-12);
+
+        // In place on the tangent vector argument
+        ManifoldVector in_place = xi;
+        M.vector_transport_into(x, eta, y, in_place, in_place);
+        EXPECT_LT(la::norm_fro(Mat(in_place.template as<T>() - transported.template as<T>())), 1e-14);
+    }
+
+    ManifoldPoint x;
+    ManifoldVector eta, xi;
+};
+
+typedef ::testing::Types<double, la::cx_double> Scalars;
+TYPED_TEST_SUITE(StackedStiefelTest, Scalars);
+
+TYPED_TEST(StackedStiefelTest, MatchesPerCopyStiefel) {
+    struct Config {
+        MetricType metric;
+        RetractionType retraction;
+        VectorTransportType transport;
+    };
+    const Config configs[] = {
+        {CANONICAL, RT_QF, VT_PROJECTION},
+        {EUCLIDEAN, RT_QF, VT_PROJECTION},
+        {CANONICAL, RT_CAYLEY, VT_CAYLEY},
+    };
+    la::set_seed(17);
+    // n = 6 takes the small kernels, n = 20 the backend ones
+    for (int n : {6, 20}) {
+        for (const Config& c : configs) {
+            Stiefel<TypeParam> S(n, 3, c.metric, c.retraction, c.transport);
+            for (int threads : {1, 3}) {
+                SCOPED_TRACE(::testing::Message() << "n " << n << ", metric " << c.metric
+                             << ", retraction " << c.retraction << ", transport "
+                             << c.transport << ", threads " << threads);
+                this->check(S, threads);
+            }
+        }
+    }
+}
+
+} // namespace
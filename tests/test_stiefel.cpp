@@ -0,0 +1,325 @@
+#include "test_helpers.hpp"
+#include "manifolds/stiefel.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace OptimLight;
+using namespace OptimLight::test;
+
+namespace {
+
+// The Stiefel kernels against the dense n x n formulas they avoid, over the
+// reals and the complex numbers
+template <typename T>
+class StiefelTest : public ::testing::Test {
+protected:
+    typedef la::Mat<T> Mat;
+
+    const int n = 9;
+    const int p = 3;
+
+    void SetUp() override {
+        la::set_seed(11);
+        X = stiefel_point<T>(n, p);
+        Z = tangent(0.5);
+        Xi = tangent(1.0);
+    }
+
+    // A random tangent vector at X, scaled by s
+    Mat tangent(double s) const {
+        Stiefel<T> S(n, p);
+        Mat V = S.projection(ManifoldPoint(X), ManifoldVector(random_mat<T>(n, p))).template as<T>();
+        V *= T(s);
+        return V;
+    }
+
+    static Mat identity(int size) {
+        Mat I(size, size);
+        la::set_identity(I);
+        return I;
+    }
+
+    // (I - W/2)^{-1} (I + W/2) B with W = P Z X^H - X Z^H P and
+    // P = I - X X^H / 2, formed densely
+    Mat dense_cayley(const Mat& B) const {
+        const Mat P = identity(n) - T(0.5) * X * la::adjoint(X);
+        const Mat W = P * Z * la::adjoint(X) - X * la::adjoint(Z) * P;
+        const Mat A = identity(n) - T(0.5) * W;
+        const Mat R = (identity(n) + T(0.5) * W) * B;
+        Mat out(n, la::cols(B));
+        la::solve(out, A, R);
+        return out;
+    }
+
+    static double distance(const Mat& A, const Mat& B) { return la::norm_fro(Mat(A - B)); }
+
+    // Q is the polar factor of Y iff Q^H Q = I and H = Q^H Y is Hermitian
+    // positive definite with Q H = Y, as U V^H is for the SVD Y = U S V^H
+    static void expect_polar_factor(const Mat& Q, const Mat& Y) {
+        EXPECT_LT(orthonormality_error<T>(Q), 1e-12);
+        const Mat H = la::adjoint(Q) * Y;
+        EXPECT_LT(distance(H, la::adjoint(H)), 1e-12);
+        EXPECT_LT(distance(Q * H, Y), 1e-12);
+        la::vec d;
+        Mat V(la::cols(H), la::cols(H));
+        la::eig_sym(d, V, Mat(T(0.5) * (H + la::adjoint(H))));
+        EXPECT_GT(d(0), 0.0);
+    }
+
+    Mat X, Z, Xi;
+};
+
+typedef ::testing::Types<double, la::cx_double> Scalars;
+TYPED_TEST_SUITE(StiefelTest, Scalars);
+
+TYPED_TEST(StiefelTest, CayleyRetractionMatchesDenseFormula) {
+    typedef typename TestFixture::Mat Mat;
+    Stiefel<TypeParam> S(this->n, this->p, CANONICAL, RT_CAYLEY);
+    const Mat Y = S.retraction(ManifoldPoint(this->X), ManifoldVector(this->Z)).template as<TypeParam>();
+    EXPECT_LT(this->distance(Y, this->dense_cayley(this->X)), 1e-12);
+    EXPECT_LT(orthonormality_error<TypeParam>(Y), 1e-12);
+}
+
+TYPED_TEST(StiefelTest, CayleyTransportMatchesDenseFormula) {
+    typedef typename TestFixture::Mat Mat;
+    Stiefel<TypeParam> S(this->n, this->p, CANONICAL, RT_CAYLEY, VT_CAYLEY);
+    const ManifoldPoint x(this->X);
+    const ManifoldVector z(this->Z);
+    const ManifoldPoint y = S.retraction(x, z);
+    const Mat V = S.vector_transport(x, z, y, ManifoldVector(this->Xi)).template as<TypeParam>();
+    EXPECT_LT(this->distance(V, this->dense_cayley(this->Xi)), 1e-12);
+
+    // The Cayley transform is unitary, so the transport is an isometry of
+    // the Euclidean metric and lands in the tangent space at y
+    EXPECT_NEAR(la::norm_fro(V), la::norm_fro(this->Xi), 1e-12);
+    const Mat YV = la::adjoint(y.template as<TypeParam>()) * V;
+    EXPECT_LT(la::norm_fro(Mat(YV + la::adjoint(YV))), 1e-12);
+}
+
+TYPED_TEST(StiefelTest, CanonicalMetricMatchesDenseFormula) {
+    typedef typename TestFixture::Mat Mat;
+    const int n = this->n;
+    Stiefel<TypeParam> S(n, this->p, CANONICAL);
+    const Mat G = this->identity(n) - TypeParam(0.5) * this->X * la::adjoint(this->X);
+    const double expected = la::inner(this->Z, Mat(G * this->Xi));
+    const double value = S.metric(ManifoldPoint(this->X), ManifoldVector(this->Z),
+                                  ManifoldVector(this->Xi));
+    EXPECT_NEAR(value, expected, 1e-12);
+
+    // The Euclidean metric is the plain inner product
+    Stiefel<TypeParam> E(n, this->p, EUCLIDEAN);
+    EXPECT_NEAR(E.metric(ManifoldPoint(this->X), ManifoldVector(this->Z), ManifoldVector(this->Xi)),
+                la::inner(this->Z, this->Xi), 1e-12);
+}
+
+TYPED_TEST(StiefelTest, PolarRetractionsGiveThePolarFactor) {
+    typedef typename TestFixture::Mat Mat;
+    for (RetractionType type : {RT_POLAR, RT_POLAR_NS}) {
+        Stiefel<TypeParam> S(this->n, this->p, CANONICAL, type);
+        // From steps close to X, where the Gram matrix is close to I, to
+        // long ones
+        for (double s : {0.1, 1.0, 10.0}) {
+            Mat Z = this->Z;
+            Z *= TypeParam(s);
+            const Mat Q = S.retraction(ManifoldPoint(this->X), ManifoldVector(Z)).template as<TypeParam>();
+            SCOPED_TRACE(::testing::Message() << "type " << type << ", scale " << s);
+            this->expect_polar_factor(Q, Mat(this->X + Z));
+        }
+    }
+}
+
+TYPED_TEST(StiefelTest, FailedFactorisationsThrow) {
+    typedef typename TestFixture::Mat Mat;
+    // A non-finite step breaks the factorisation behind each retraction;
+    // that is reported instead of returning a non-finite point
+    Mat Z = this->Z;
+    Z(0, 0) = TypeParam(std::nan(""));
+    for (RetractionType type : {RT_QF, RT_CAYLEY, RT_EXP}) {
+        Stiefel<TypeParam> S(this->n, this->p, CANONICAL, type);
+        EXPECT_THROW(S.retraction(ManifoldPoint(this->X), ManifoldVector(Z)), std::runtime_error)
+            << "type " << type;
+    }
+}
+
+TYPED_TEST(StiefelTest, RetractionCurveMatchesRetraction) {
+    typedef typename TestFixture::Mat Mat;
+    const ManifoldPoint x(this->X);
+    const ManifoldVector z(this->Z);
+    for (int type = 0; type < RetractionTypeLength; ++type) {
+        Stiefel<TypeParam> S(this->n, this->p, CANONICAL, static_cast<RetractionType>(type));
+        std::unique_ptr<RetractionCurve> curve = S.retraction_curve(x, z);
+        ManifoldPoint y;
+        for (double t : {-1.5, -0.3, 0.0, 0.4, 1.0, 2.0}) {
+            Mat tZ = this->Z;
+            tZ *= TypeParam(t);
+            const ManifoldPoint expected = S.retraction(x, ManifoldVector(tZ));
+            curve->evaluate(t, y);
+            EXPECT_LT(this->distance(y.template as<TypeParam>(), expected.template as<TypeParam>()),
+                      1e-12) << "type " << type << ", t = " << t;
+        }
+
+        // Rebound to another point and direction, the curve follows them
+        const ManifoldPoint x2(stiefel_point<TypeParam>(this->n, this->p));
+        const ManifoldVector z2 = S.projection(x2, ManifoldVector(random_mat<TypeParam>(this->n, this->p)));
+        RetractionCurve* const before = curve.get();
+        S.retraction_curve_into(x2, z2, curve);
+        EXPECT_EQ(curve.get(), before) << "type " << type;
+        for (double t : {-0.5, 0.7}) {
+            ManifoldVector tz = z2;
+            tz *= t;
+            const ManifoldPoint expected = S.retraction(x2, tz);
+            curve->evaluate(t, y);
+            EXPECT_LT(this->distance(y.template as<TypeParam>(), expected.template as<TypeParam>()),
+                      1e-12) << "type " << type << " after reset, t = " << t;
+        }
+
+        // A curve of another manifold is replaced, not rebound
+        Stiefel<TypeParam> other(this->n, this->p, CANONICAL, static_cast<RetractionType>(type));
+        other.retraction_curve_into(x, z, curve);
+        EXPECT_NE(curve.get(), before) << "type " << type;
+    }
+}
+
+TYPED_TEST(StiefelTest, BatchedTransportsMatchSingleOnes) {
+    typedef typename TestFixture::Mat Mat;
+    const ManifoldPoint x(this->X);
+    const ManifoldVector z(this->Z);
+    const std::vector<Mat> vectors = {this->Xi, this->tangent(2.0), this->tangent(0.1)};
+    for (int vt = 0; vt < VectorTransportTypeLength; ++vt) {
+        Stiefel<TypeParam> S(this->n, this->p, CANONICAL, RT_CAYLEY,
+                             static_cast<VectorTransportType>(vt));
+        const ManifoldPoint y = S.retraction(x, z);
+        std::vector<ManifoldVector> many, both;
+        std::vector<ManifoldVector*> many_ptrs, both_ptrs;
+        for (const Mat& v : vectors) {
+            many.emplace_back(v);
+            both.emplace_back(v);
+        }
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            many_ptrs.push_back(&many[i]);
+            both_ptrs.push_back(&both[i]);
+        }
+
+        std::vector<ManifoldVector> single;
+        try {
+            for (const Mat& v : vectors) {
+                single.push_back(S.vector_transport(x, z, y, ManifoldVector(v)));
+            }
+        } catch (const std::runtime_error&) {
+            // A type without a single transport has no batched one either
+            EXPECT_THROW(S.vector_transport_many(x, z, y, many_ptrs), std::runtime_error)
+                << "type " << vt;
+            ManifoldPoint y2;
+            EXPECT_THROW(S.retract_and_transport(x, z, y2, both_ptrs), std::runtime_error)
+                << "type " << vt;
+            continue;
+        }
+
+        S.vector_transport_many(x, z, y, many_ptrs);
+        ManifoldPoint y2;
+        S.retract_and_transport(x, z, y2, both_ptrs);
+        EXPECT_LT(this->distance(y2.template as<TypeParam>(), y.template as<TypeParam>()), 1e-14)
+            << "type " << vt;
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            const Mat& expected = single[i].template as<TypeParam>();
+            EXPECT_LT(this->distance(many[i].template as<TypeParam>(), expected), 1e-12)
+                << "type " << vt << ", vector " << i;
+            EXPECT_LT(this->distance(both[i].template as<TypeParam>(), expected), 1e-12)
+                << "type " << vt << ", vector " << i;
+        }
+    }
+}
+
+TYPED_TEST(StiefelTest, GradientAndHessianConversions) {
+    typedef typename TestFixture::Mat Mat;
+    const int n = this->n;
+    const int p = this->p;
+    // X^H V + V^H X vanishes for a tangent V at X
+    auto tangency = [](const Mat& X, const Mat& V) {
+        const Mat XV = la::adjoint(X) * V;
+        return la::norm_fro(Mat(XV + la::adjoint(XV)));
+    };
+    for (MetricType metric : {EUCLIDEAN, CANONICAL}) {
+        SCOPED_TRACE(::testing::Message() << "metric " << metric);
+        BasicBrockett<TypeParam> problem(n, p, metric, true);
+        const Stiefel<TypeParam>& S = problem.stiefel();
+        const ManifoldPoint x(this->X);
+        const Mat& X = this->X;
+        const ManifoldVector egrad = problem.gradient(x);
+
+        // The Riemannian gradient is tangent, and the returned value is its
+        // norm in the metric
+        ManifoldVector rgrad;
+        Array correction;
+        const double norm = S.egrad_to_rgrad(x, egrad, rgrad, &correction);
+        EXPECT_LT(tangency(X, rgrad.template as<TypeParam>()), 1e-12);
+        EXPECT_NEAR(norm, std::sqrt(S.metric(x, rgrad, rgrad)), 1e-12 * norm);
+        ManifoldVector without;
+        S.egrad_to_rgrad(x, egrad, without);
+        EXPECT_LT(this->distance(without.template as<TypeParam>(), rgrad.template as<TypeParam>()),
+                  1e-14);
+
+        // It represents the differential of f in the metric:
+        // <rgrad, xi>_x = Re tr(egrad^H xi) for every tangent xi
+        const ManifoldVector xi(this->Xi);
+        const ManifoldVector eta(this->tangent(2.0));
+        EXPECT_NEAR(S.metric(x, rgrad, xi), la::inner(egrad.template as<TypeParam>(), this->Xi),
+                    1e-12 * norm);
+
+        // The Hessian is tangent and self-adjoint in the metric
+        ManifoldVector hxi, heta;
+        S.ehess_to_rhess(x, egrad, problem.euclidean_hessian_vector(x, xi), xi, hxi, &correction);
+        S.ehess_to_rhess(x, egrad, problem.euclidean_hessian_vector(x, eta), eta, heta, &correction);
+        const double scale = la::norm_fro(hxi.template as<TypeParam>()) *
+                             la::norm_fro(eta.template as<TypeParam>());
+        EXPECT_LT(tangency(X, hxi.template as<TypeParam>()), 1e-12 * scale);
+        EXPECT_LT(tangency(X, heta.template as<TypeParam>()), 1e-12 * scale);
+        EXPECT_NEAR(S.metric(x, hxi, eta), S.metric(x, xi, heta), 1e-12 * scale);
+
+        // Without the correction it is formed again, to the same result
+        ManifoldVector hxi_without;
+        S.ehess_to_rhess(x, egrad, problem.euclidean_hessian_vector(x, xi), xi, hxi_without);
+        EXPECT_LT(this->distance(hxi_without.template as<TypeParam>(), hxi.template as<TypeParam>()),
+                  1e-14 * scale);
+
+        if (metric == EUCLIDEAN) {
+            // The finite-difference path of the same problem, whose
+            // projection transport belongs to this metric, agrees to O(h)
+            ManifoldVector fd;
+            problem.finite_difference_hessian(x, rgrad, xi, fd);
+            EXPECT_LT(this->distance(fd.template as<TypeParam>(), hxi.template as<TypeParam>()),
+                      1e-3 * la::norm_fro(hxi.template as<TypeParam>()));
+            continue;
+        }
+
+        // <Hess xi, xi> is the second derivative of f along the geodesic,
+        // which RT_EXP follows for the canonical metric
+        const Stiefel<TypeParam> geodesic(n, p, CANONICAL, RT_EXP);
+        const double t = 1e-4;
+        ManifoldVector step = xi;
+        step *= t;
+        const double ahead = problem.objective_function(geodesic.retraction(x, step));
+        step *= -1.0;
+        const double behind = problem.objective_function(geodesic.retraction(x, step));
+        const double second = (ahead - 2.0 * problem.objective_function(x) + behind) / (t * t);
+        EXPECT_NEAR(S.metric(x, hxi, xi), second, 1e-4 * std::fabs(second));
+
+        // Finite differences of the gradient transported by projection
+        // converge to the canonical Hessian only where the gradient
+        // vanishes, at a critical point such as the minimizer
+        const ManifoldPoint xmin = problem.minimizer();
+        const ManifoldVector egrad_min = problem.gradient(xmin);
+        const ManifoldVector zeta = S.projection(xmin, ManifoldVector(random_mat<TypeParam>(n, p)));
+        ManifoldVector rgrad_min, hzeta, fd;
+        S.egrad_to_rgrad(xmin, egrad_min, rgrad_min);
+        S.ehess_to_rhess(xmin, egrad_min, problem.euclidean_hessian_vector(xmin, zeta), zeta, hzeta);
+        problem.finite_difference_hessian(xmin, rgrad_min, zeta, fd);
+        EXPECT_LT(this->distance(fd.template as<TypeParam>(), hzeta.template as<TypeParam>()),
+                  1e-3 * la::norm_fro(hzeta.template as<TypeParam>()));
+    }
+}
+
+} // namespace